@@ -0,0 +1,20 @@
+#ifndef ACCEL_CURVE_H
+#define ACCEL_CURVE_H
+
+#include "common.h"
+
+#define ACCEL_CURVE_SIZE      512
+#define ACCEL_CURVE_MAX_SPEED 2000.0f  // deg/s covered by the table, faster input uses the last entry
+
+// Pointer gain as a function of angular speed, tabulated once from the
+// configured profile so per-sample evaluation is a lookup and a lerp
+typedef struct {
+    float gain[ACCEL_CURVE_SIZE + 1];
+    float step;                        // deg/s between entries
+} AccelCurve;
+
+// Function declarations
+void accel_curve_build(AccelCurve* curve, const MouseConfig* cfg);
+float accel_curve_gain(const AccelCurve* curve, float speed);
+
+#endif
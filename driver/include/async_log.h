@@ -0,0 +1,34 @@
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <stdint.h>
+#include <syslog.h>
+
+// Records above this syslog level compile to nothing. The Makefile builds
+// with LOG_INFO unless asked for make LOG_LEVEL=LOG_DEBUG.
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_DEBUG
+#endif
+
+#define ASYNC_LOG_CAPACITY 1024  // Records, must be a power of two
+#define ASYNC_LOG_MAX_ARGS 8
+
+// Non-blocking logging for the input path. Only the format pointer and the
+// numeric arguments are stored; a background thread formats and hands them
+// to syslog. The format must be a string literal and may only use numeric
+// conversions (%d, %u, %x, %c, %f, %g, ... with any flags, width or length
+// modifier), since every argument is carried as a double.
+#define ASYNC_LOG(level, format, ...) do { \
+    if ((level) <= LOG_COMPILE_LEVEL) { \
+        const double async_log_args_[] = {0, ##__VA_ARGS__}; \
+        async_log_record((level), (format), async_log_args_ + 1, \
+                         (int)(sizeof(async_log_args_) / sizeof(double)) - 1); \
+    } \
+} while (0)
+
+// Function declarations
+int async_log_start(int runtime_level);
+void async_log_stop();
+void async_log_record(int level, const char* format, const double* args, int nargs);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef AXES_REMAP_H
+#define AXES_REMAP_H
+
+#include <stdbool.h>
+#include "FusionAxes.h"
+
+// Sensor-to-body remap for one mounting orientation. Each entry is
+// FusionAxesSwap with the alignment fixed at compile time, so the switch
+// folds away and the hot path is a plain call through this pointer.
+typedef FusionVector (*AxesRemap)(FusionVector sensor);
+
+// Function declarations
+AxesRemap axes_remap_for(FusionAxesAlignment alignment);
+bool axes_alignment_parse(const char* name, FusionAxesAlignment* alignment);
+const char* axes_alignment_name(FusionAxesAlignment alignment);
+
+#endif
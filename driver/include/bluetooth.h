@@ -5,27 +5,76 @@
 #include <stdint.h>
 #include <dbus/dbus.h>
 #include "common.h"
+#include "event_loop.h"
+#include "packet_queue.h"
 
 #define SERVICE_UUID "12345678-1234-1234-1234-123456789abc"
 #define CHARACTERISTIC_UUID "87654321-4321-4321-4321-cba987654321"
 
-typedef struct {
+typedef struct BLEConnection BLEConnection;
+
+// Consumer hook, run from the event loop once decoded samples are queued
+typedef void (*SampleCallback)(BLEConnection* conn, void* user_data);
+
+// Outcome of connect_device_async(), reported once from the event loop
+typedef void (*ConnectCallback)(BLEConnection* conn, bool connected, void* user_data);
+
+typedef enum {
+    CONNECT_IDLE,
+    CONNECT_REQUESTED,         // Device1.Connect sent, reply pending
+    CONNECT_RESOLVING          // Connected, waiting for ServicesResolved
+} ConnectPhase;
+
+// Reports every matching controller BlueZ knows of or discovers; name may be
+// empty until BlueZ has resolved it
+typedef void (*DeviceFoundCallback)(const char* device_path, const char* name, const char* address,
+                                    void* user_data);
+
+struct BLEConnection {
     char device_path[256];
     char device_name[128];
+    char device_address[18];   // AA:BB:CC:DD:EE:FF of the connected device
     char service_path[256];
     char char_path[256];
     bool connected;
     bool scanning;
     DBusConnection* dbus_conn;
-    SensorPacket last_packet;
-    bool packet_ready;
-} BLEConnection;
+    PacketQueue queue;         // Filled by the notification handler, drained by on_samples
+    uint16_t next_sequence;    // Expected SensorFrameHeader.sequence
+    bool sequence_valid;
+    uint32_t frames_lost;      // Frames missing from the sequence (lost in transport)
+    uint32_t notifications;    // Notification payloads received
+    uint64_t payload_bytes;    // Bytes in those payloads
+    uint32_t samples;          // Samples decoded from them
+    int notify_fd;             // AcquireNotify socket, -1 when notifications come over D-Bus
+    char device_match[512];    // Bus match rules added while connected, empty when not added
+    char char_match[512];
+    char cached_device_path[256]; // Last paths that connected, kept across disconnects
+    char cached_char_path[256];
+    SampleCallback on_samples;
+    void* on_samples_data;
+    ConnectPhase connect_phase;
+    DBusPendingCall* pending_call; // Connect or ServicesResolved query in flight
+    int resolve_timer_fd;      // Deadline for ServicesResolved while resolving
+    bool services_resolved;
+    ConnectCallback on_connect;
+    void* on_connect_data;
+};
 
 // Function declarations
 int init_bluetooth();
+int bluetooth_attach_event_loop(EventLoop* loop);
+int start_discovery(DeviceFoundCallback callback, void* user_data);
+void stop_discovery();
 int scan_for_device(BLEConnection* conn);
+int connect_device_async(BLEConnection* conn, ConnectCallback callback, void* user_data);
+void cancel_connect(BLEConnection* conn);
 int connect_to_device(BLEConnection* conn);
-int read_sensor_data(BLEConnection* conn, SensorPacket* packet);
+int reconnect_cached_device(BLEConnection* conn, ConnectCallback callback, void* user_data);
+void load_device_cache(BLEConnection* conn, const char* file_path);
+void save_device_cache(const BLEConnection* conn, const char* file_path);
+bool bluetooth_dispatch();
+int read_sensor_data(BLEConnection* conn, SensorSample* sample);
 void disconnect_device(BLEConnection* conn);
 void cleanup_bluetooth();
 
@@ -0,0 +1,48 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "Fusion.h"
+
+#define CALIBRATION_POSES 6  // +X, -X, +Y, -Y, +Z, -Z pointing up
+
+// Parameters of FusionCalibrationInertial for one sensor
+typedef struct {
+    FusionMatrix misalignment;
+    FusionVector sensitivity;
+    FusionVector offset;
+} InertialCalibration;
+
+typedef struct {
+    InertialCalibration gyroscope;
+    InertialCalibration accelerometer;
+} ImuCalibration;
+
+// FusionCalibrationInertial folded into one affine map:
+// misalignment * diag(sensitivity) * (raw - offset) == matrix * raw - bias
+typedef struct {
+    FusionMatrix matrix;
+    FusionVector bias;
+} FusedCalibration;
+
+// Mean readings of one static pose
+typedef struct {
+    FusionVector accelerometer;   // g
+    FusionVector gyroscope;       // deg/s
+} CalibrationPose;
+
+static inline FusionVector calibration_apply(const FusedCalibration* cal, FusionVector raw) {
+    return FusionVectorSubtract(FusionMatrixMultiplyVector(cal->matrix, raw), cal->bias);
+}
+
+// Function declarations
+void imu_calibration_identity(ImuCalibration* cal);
+void calibration_fuse(const InertialCalibration* cal, FusedCalibration* fused);
+int calibration_solve(const CalibrationPose poses[CALIBRATION_POSES], ImuCalibration* cal);
+bool calibration_path(const char* address, char* path, size_t size);
+int imu_calibration_load(ImuCalibration* cal, const char* file_path);
+int imu_calibration_save(const ImuCalibration* cal, const char* file_path);
+int run_calibration();
+
+#endif
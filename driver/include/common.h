@@ -3,6 +3,9 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "FusionAxes.h"
+#include "sample_codec.h"
+#include "sensor_frame.h"
 
 #define SERVICE_UUID        "12345678-1234-1234-1234-123456789abc"
 #define CHARACTERISTIC_UUID "87654321-4321-4321-4321-cba987654321"
@@ -11,24 +14,144 @@ typedef struct {
     int16_t accel_x, accel_y, accel_z; // Acceleration * 100 (e.g., 1.5g = 150)
     int16_t gyro_x, gyro_y, gyro_z;    // Gyroscope * 10 (e.g., 5.5 deg/s = 55)
     uint8_t button_state;               // 0=none, 1=press, 2=long_press
-    uint8_t padding;                    // Padding for alignment
-    uint16_t timestamp;                 // Millisecond counter (wraps every 65 seconds)
+    uint8_t button_sequence;            // Count of button_state changes, wraps (0 from older firmware)
+    uint16_t timestamp;                 // Bare packet: millisecond counter; in a v2 frame: microseconds (low 16 bits)
 } __attribute__((packed)) SensorPacket;
 // Size: 6*2 + 1 + 1 + 2 = 16 bytes (fits in 20 byte BLE MTU)
 
+// Sample of a version 4 frame: orientation and linear acceleration from the
+// AHRS running on the device. Same size and trailing fields as SensorPacket.
 typedef struct {
+    int16_t quat_x, quat_y, quat_z;    // Quaternion vector part * 32767, sent with w >= 0
+    int16_t linear_x, linear_y, linear_z; // Linear acceleration (sensor frame, gravity removed) * 1000
+    uint8_t button_state;
+    uint8_t button_sequence;
+    uint16_t timestamp;                 // Microseconds (low 16 bits)
+} __attribute__((packed)) FusedPacket;
+
+#define FUSED_QUATERNION_SCALE 32767.0f
+#define FUSED_LINEAR_SCALE     1000.0f
+
+// Batched notification: header followed by `count` SensorPackets. Sent
+// when the negotiated MTU has room for more than one sample; a bare
+// 16-byte SensorPacket is still accepted from older firmware.
+#define SENSOR_FRAME_VERSION_DELTA 5 // Raw LSB readings, delta/varint coded (DeltaFrameInfo)
+#define SENSOR_FRAME_VERSION_FUSED 4 // Version 3 layout carrying FusedPackets
+#define SENSOR_FRAME_VERSION     3   // Microsecond timestamps plus button event history
+#define SENSOR_FRAME_VERSION_US  2   // Microsecond timestamps, no button history
+#define SENSOR_FRAME_VERSION_MS  1   // Older firmware: millisecond timestamps
+#define SENSOR_NOTIFY_MAX_LEN    (sizeof(SensorFrameHeader) + sizeof(ButtonEventHistory) + \
+                                  SENSOR_FRAME_MAX_SAMPLES * sizeof(SensorPacket))
+
+typedef struct {
+    uint8_t version;    // SENSOR_FRAME_VERSION
+    uint8_t count;      // Samples following the header
+    uint16_t sequence;  // Frame counter, wraps at 65536
+    uint32_t timestamp; // Full time of the first sample (us, ms for version 1)
+} __attribute__((packed)) SensorFrameHeader;
+
+// One button_state change, numbered like SensorPacket.button_sequence
+typedef struct {
+    uint8_t sequence;
+    uint8_t state;
+} __attribute__((packed)) ButtonEventRecord;
+
+// Follows the header in version 3 frames, oldest first. Repeating the last
+// few changes in every frame lets the driver recover a click whose packets
+// were all lost.
+typedef struct {
+    ButtonEventRecord events[BUTTON_EVENT_HISTORY];
+} __attribute__((packed)) ButtonEventHistory;
+
+// Follows the button history in version 5 frames, before the coded
+// samples. The firmware starts a new frame when the button state changes,
+// so one state and sequence number covers every sample.
+typedef struct {
+    uint8_t button_state;
+    uint8_t button_sequence;
+    SampleBlockHeader block;
+} __attribute__((packed)) DeltaFrameInfo;
+
+// Decoded sample as handed from the transport to the motion pipeline
+typedef struct {
+    SensorPacket packet;  // Buttons and timestamp; a FusedPacket when fused is set
+    FusionVector accelerometer; // g, from whichever encoding the sample arrived in (raw samples only)
+    FusionVector gyroscope;     // deg/s
+    bool fused;           // Orientation fused on the device (version 4 frame)
+    uint32_t device_time; // Device timestamp in ticks of tick_hz, extended to time_bits
+    uint32_t tick_hz;     // 1000 for bare packets and v1 frames, 1000000 for v2 frames
+    uint8_t time_bits;    // 16 for bare packets, 32 when unwrapped from a frame header
+    uint64_t arrival_ns;  // Host arrival time (CLOCK_MONOTONIC)
+    bool has_button_history;        // Frame carried button_history (version 3)
+    ButtonEventHistory button_history;
+} SensorSample;
+
+typedef enum {
+    POINTER_MODE_RELATIVE,      // Integrated linear acceleration, REL_X/REL_Y
+    POINTER_MODE_ABSOLUTE,      // Orientation mapped to ABS_X/ABS_Y
+    POINTER_MODE_GYRO           // Yaw/pitch rate through an acceleration curve, REL_X/REL_Y
+} PointerMode;
+
+typedef enum {
+    ACCEL_PROFILE_FLAT,         // Constant gain
+    ACCEL_PROFILE_LINEAR,       // Piecewise linear above accel_threshold
+    ACCEL_PROFILE_POWER,        // Power law with accel_exponent
+    ACCEL_PROFILE_ADAPTIVE      // libinput-style: slow-motion deceleration plus incline
+} AccelProfile;
+
+typedef enum {
+    MOTION_FILTER_NONE,         // Bypass
+    MOTION_FILTER_ONE_EURO,     // Speed-adaptive low-pass
+    MOTION_FILTER_KALMAN        // Constant-velocity Kalman filter
+} MotionFilterType;
+
+typedef struct {
+    PointerMode pointer_mode;
+    FusionAxesAlignment mounting; // Sensor axes relative to the body axes the pipeline expects
+    float absolute_yaw_range;   // Degrees of yaw spanning the screen width in absolute mode
+    float absolute_pitch_range; // Degrees of pitch spanning the screen height
+    float gyro_sensitivity;     // Gyro mode: pixels per degree of rotation at gain 1
+    float gyro_dead_zone;       // Gyro mode: angular speed (deg/s) treated as still
+    AccelProfile accel_profile;
+    float accel_threshold;      // Angular speed (deg/s) where acceleration starts
+    float accel_max_gain;
+    float accel_exponent;       // Power profile exponent
+    MotionFilterType motion_filter; // Smoothing of the cursor velocity (px/s) in relative and gyro mode
+    float filter_min_cutoff;    // One-Euro: cutoff (Hz) when still
+    float filter_beta;          // One-Euro: cutoff increase per px/s of velocity change
+    float filter_d_cutoff;      // One-Euro: cutoff (Hz) of the derivative estimate
+    float filter_process_noise; // Kalman: velocity random walk, (px/s^2)^2 per second
+    float filter_measurement_noise; // Kalman: jitter of the input, (px/s)^2
+    float zupt_gyro_threshold;  // Relative mode: rotation (deg/s) below which the device may be still, 0 disables
+    float zupt_accel_stddev;    // Relative mode: accel magnitude spread (g) below which it is still
+    float velocity_highpass;    // Relative mode: high-pass time constant (s) on cursor velocity, 0 disables
     float movement_sensitivity;
-    float scroll_sensitivity;
+    bool scroll_enabled;        // Relative mode: tilt scrolls and holds the cursor, off by default
+    float scroll_sensitivity;   // Tilt scroll speed multiplier, 0 disables scrolling
     float dead_zone;
-    float scroll_threshold;
+    float scroll_threshold;     // Tilt (g of gravity along the axis) before scrolling starts
     bool invert_x;
     bool invert_y;
     bool invert_scroll;
-    int scroll_filter_samples;
+    int scroll_filter_samples;  // Moving-average window for the tilt, 1-10
+    bool acquire_notify;        // Read notifications from a BlueZ AcquireNotify socket
+    char state_dir[256];        // Persistent daemon state (device cache); empty disables
+    int max_devices;            // Controllers served at once, including configured devices
 } MouseConfig;
 
+#define MAX_DEVICES 16
+
+// Per-controller section from the `devices:` list
+typedef struct {
+    char name[128];             // Claim controllers whose name contains this (empty: any)
+    char address[18];           // Claim only this Bluetooth address (empty: any)
+    MouseConfig config;         // Global settings with this device's overrides applied
+} DeviceConfig;
+
 // Global configuration
 extern MouseConfig config;
+extern DeviceConfig device_configs[MAX_DEVICES];
+extern int device_config_count;
 extern bool running;
 
 // Function declarations
@@ -0,0 +1,58 @@
+#ifndef DEVICE_MANAGER_H
+#define DEVICE_MANAGER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "common.h"
+#include "bluetooth.h"
+#include "pipeline.h"
+#include "timing.h"
+#include "uinput.h"
+
+#define RECONNECT_BACKOFF_MIN_MS 100
+#define RECONNECT_BACKOFF_MAX_MS 5000
+#define RECONNECT_FAST_ATTEMPTS  5   // Cached-path attempts before waiting on discovery again
+
+typedef enum {
+    DEVICE_SEARCHING,   // Waiting for discovery to report a controller for this slot
+    DEVICE_PENDING,     // Path known, connection attempt due at next_attempt_ns
+    DEVICE_CONNECTING,  // Connect sent, waiting for BlueZ from the event loop
+    DEVICE_CONNECTED
+} DeviceState;
+
+// One controller slot: its BLE link, motion pipeline and uinput node. The uinput
+// node lives as long as the daemon so reconnects keep the same input device.
+typedef struct {
+    int index;
+    MouseConfig config;          // Global settings with this slot's overrides applied
+    char match_name[128];        // Only claim controllers whose name contains this
+    char match_address[18];      // Only claim this Bluetooth address
+    char cache_file[512];        // Device cache for fast reconnects, empty disables
+    DeviceState state;
+    BLEConnection conn;
+    MotionPipeline pipeline;
+    UInputDevice uinput;
+    unsigned int backoff_ms;
+    unsigned int fast_attempts;
+    uint64_t next_attempt_ns;
+    LatencyHistogram latency;    // Time from notification arrival to the uinput write it produced
+    char offset_address[18];     // Controller the pipeline's gyro offset was learned on
+    bool offset_saved;           // Converged offset written to the state directory
+} MouseDevice;
+
+typedef struct {
+    MouseDevice devices[MAX_DEVICES];
+    int count;
+    bool discovering;
+    uint64_t cpu_window_start_ns;       // Process CPU time per received packet
+    uint32_t cpu_window_notifications;
+} DeviceManager;
+
+// Function declarations
+int device_manager_init(DeviceManager* manager);
+void device_manager_poll(DeviceManager* manager);
+int device_manager_timeout_ms(const DeviceManager* manager);
+void device_manager_report(DeviceManager* manager);
+void device_manager_cleanup(DeviceManager* manager);
+
+#endif
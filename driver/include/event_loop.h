@@ -0,0 +1,34 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#define EVENT_LOOP_MAX_SOURCES 64  // D-Bus watches and timeouts, timers and a notification socket per device
+
+// Called with the ready fd and the epoll event mask that fired
+typedef void (*EventCallback)(int fd, uint32_t events, void* user_data);
+
+typedef struct {
+    int fd;                 // -1 when the slot is free
+    bool is_timer;          // timerfd: expirations are consumed before the callback runs
+    EventCallback callback;
+    void* user_data;
+} EventSource;
+
+typedef struct {
+    int epoll_fd;
+    EventSource sources[EVENT_LOOP_MAX_SOURCES];
+} EventLoop;
+
+// Function declarations
+int event_loop_init(EventLoop* loop);
+int event_loop_add(EventLoop* loop, int fd, uint32_t events, EventCallback callback, void* user_data);
+int event_loop_modify(EventLoop* loop, int fd, uint32_t events);
+void event_loop_remove(EventLoop* loop, int fd);
+int event_loop_add_timer(EventLoop* loop, unsigned int interval_ms, EventCallback callback, void* user_data);
+int event_loop_run_once(EventLoop* loop, int timeout_ms);
+void event_loop_cleanup(EventLoop* loop);
+
+#endif
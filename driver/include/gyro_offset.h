@@ -0,0 +1,32 @@
+#ifndef GYRO_OFFSET_H
+#define GYRO_OFFSET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "FusionOffset.h"
+
+#define GYRO_OFFSET_NOMINAL_RATE   200    // Hz, until the packet rate has been measured
+#define GYRO_OFFSET_RATE_WINDOW_S  2.0f   // Sample time per rate measurement
+#define GYRO_OFFSET_RATE_TOLERANCE 0.1f   // Re-initialise FusionOffset beyond this rate error
+#define GYRO_OFFSET_CONVERGED_S    10.0f  // Stationary refinement before the estimate is trusted
+
+// FusionOffset run at the measured sample rate, plus how long it has been
+// refining its estimate. A converged offset can be saved and restored so a
+// fresh connection starts without drift.
+typedef struct {
+    FusionOffset offset;
+    unsigned int sample_rate;     // Rate FusionOffset is initialised for
+    float window_s;               // Rate measurement window
+    unsigned int window_samples;
+    float adjusted_s;             // Time spent refining the offset while stationary
+    bool converged;
+} GyroOffset;
+
+// Function declarations
+void gyro_offset_init(GyroOffset* gyro);
+FusionVector gyro_offset_update(GyroOffset* gyro, FusionVector gyroscope, float dt);
+FusionVector gyro_offset_get(const GyroOffset* gyro);
+void gyro_offset_restore(GyroOffset* gyro, FusionVector offset, bool converged);
+bool gyro_offset_path(const char* address, char* path, size_t size);
+
+#endif
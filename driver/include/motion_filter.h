@@ -0,0 +1,55 @@
+#ifndef MOTION_FILTER_H
+#define MOTION_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "common.h"
+
+typedef struct MotionFilter MotionFilter;
+
+// Filters one axis sample taken dt seconds after the previous one
+typedef float (*MotionFilterStep)(MotionFilter* filter, int axis, float value, float dt);
+
+typedef struct {
+    float x_prev;                 // Filtered value
+    float dx_prev;                // Filtered derivative
+    bool initialized;
+} OneEuroAxis;
+
+typedef struct {
+    float x, v;                   // Position and velocity estimate
+    float p00, p01, p11;          // Symmetric covariance
+    bool initialized;
+} KalmanAxis;
+
+// Added latency versus jitter reduction, measured on the live signal.
+// Jitter is the RMS second difference, latency the tracking error over
+// the input slope (exact for ramps through a first-order filter).
+typedef struct {
+    uint32_t samples;
+    double jitter_in, jitter_out; // Sums of squared second differences
+    double error_sum, slope_sum;  // Sums of |output - input| and |input slope| (per second)
+    float in_prev[2][2], out_prev[2][2]; // Last two samples per axis
+} MotionFilterStats;
+
+// Smoothing between the world-acceleration or rate output and the
+// sub-pixel accumulator, two axes (screen x and y)
+struct MotionFilter {
+    MotionFilterType type;
+    MotionFilterStep step;        // Chosen once at init from type
+    const MouseConfig* config;
+    union {
+        OneEuroAxis one_euro[2];
+        KalmanAxis kalman[2];
+    } axis;
+    MotionFilterStats stats;
+};
+
+// Function declarations
+void motion_filter_init(MotionFilter* filter, const MouseConfig* cfg);
+void motion_filter_apply(MotionFilter* filter, float* x, float* y, float dt);
+bool motion_filter_measure(const MotionFilter* filter, double* jitter_reduction, double* latency_ms);
+void motion_filter_log_stats(MotionFilter* filter, const char* label);
+const char* motion_filter_name(MotionFilterType type);
+
+#endif
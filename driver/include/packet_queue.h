@@ -0,0 +1,76 @@
+#ifndef PACKET_QUEUE_H
+#define PACKET_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "common.h"
+
+#define PACKET_QUEUE_CAPACITY 128 // Must be a power of two
+
+// Single-producer/single-consumer ring of sensor samples. The producer owns
+// head, the consumer owns tail; each side only reads the other's index.
+typedef struct {
+    SensorSample slots[PACKET_QUEUE_CAPACITY];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t overflows; // Pushes that found the queue full
+    uint32_t dropped;   // Packets discarded: overflows plus malformed notifications
+} PacketQueue;
+
+static inline void packet_queue_init(PacketQueue* queue) {
+    queue->head = 0;
+    queue->tail = 0;
+    queue->overflows = 0;
+    queue->dropped = 0;
+}
+
+static inline uint32_t packet_queue_size(const PacketQueue* queue) {
+    return __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+}
+
+static inline uint32_t packet_queue_space(const PacketQueue* queue) {
+    return PACKET_QUEUE_CAPACITY - packet_queue_size(queue);
+}
+
+// Producer side, zero-copy: returns the next free slot to fill in place, or
+// NULL when the queue is full. The newest packet is dropped in that case
+// since the producer may not move the consumer's tail.
+static inline SensorSample* packet_queue_reserve(PacketQueue* queue) {
+    uint32_t head = queue->head;
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail >= PACKET_QUEUE_CAPACITY) {
+        queue->overflows++;
+        queue->dropped++;
+        return NULL;
+    }
+    return &queue->slots[head & (PACKET_QUEUE_CAPACITY - 1)];
+}
+
+// Publishes the slot returned by packet_queue_reserve()
+static inline void packet_queue_commit(PacketQueue* queue) {
+    __atomic_store_n(&queue->head, queue->head + 1, __ATOMIC_RELEASE);
+}
+
+static inline bool packet_queue_push(PacketQueue* queue, const SensorSample* sample) {
+    SensorSample* slot = packet_queue_reserve(queue);
+    if (!slot) return false;
+
+    *slot = *sample;
+    packet_queue_commit(queue);
+    return true;
+}
+
+// Consumer side
+static inline bool packet_queue_pop(PacketQueue* queue, SensorSample* out) {
+    uint32_t tail = queue->tail;
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+
+    if (tail == head) return false;
+
+    *out = queue->slots[tail & (PACKET_QUEUE_CAPACITY - 1)];
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+#endif
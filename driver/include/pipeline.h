@@ -0,0 +1,84 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "common.h"
+#include "accel_curve.h"
+#include "axes_remap.h"
+#include "calibration.h"
+#include "gyro_offset.h"
+#include "motion_filter.h"
+#include "scroll.h"
+#include "timebase.h"
+#include "zupt.h"
+#include "Fusion.h"
+
+#define MOTION_BUTTON_LEFT  0x01
+#define MOTION_BUTTON_RIGHT 0x02
+
+// Replayed history, a synthesized click and the current state, each of which
+// may release a held-back right button as a whole click first
+#define MOTION_BUTTON_CHANGES ((BUTTON_EVENT_HISTORY + 2) * 2)
+
+#define MOTION_ABS_MAX 65535  // Absolute axis range, well above screen resolution for sub-pixel steps
+
+// One button transition, emitted as its own SYN_REPORT
+typedef struct {
+    uint8_t pressed;              // MOTION_BUTTON_* that went down
+    uint8_t released;             // MOTION_BUTTON_* that came up
+} ButtonChange;
+
+// What one sample asks the output device to do
+typedef struct {
+    int dx, dy;                   // Relative pointer motion, already clamped
+    int abs_x, abs_y;             // Absolute position, 0..MOTION_ABS_MAX
+    bool has_position;            // abs_x/abs_y changed
+    ScrollOutput scroll;          // Wheel motion from tilt
+    ButtonChange buttons[MOTION_BUTTON_CHANGES]; // Button changes in the order they happened
+    unsigned int button_count;
+} MotionReport;
+
+// Everything needed to turn a stream of samples from one controller into
+// pointer reports. Owns no file descriptors, so any number of instances can
+// run side by side in the daemon or in offline tools.
+typedef struct {
+    const MouseConfig* config;
+    FusionAhrs ahrs;              // Fusion AHRS algorithm
+    GyroOffset gyro_offset;       // Run-time gyro bias estimate, kept across resets
+    FusedCalibration gyroscope_calibration;     // Per-device IMU calibration, kept across resets
+    FusedCalibration accelerometer_calibration;
+    AxesRemap remap;              // Sensor-to-body axes for the configured mounting
+    FusionQuaternion mounting;    // The same remap as a rotation, for orientations fused on the device
+    bool fused;                   // Orientation comes from the device, the local AHRS is idle
+    FusionQuaternion last_quaternion; // Previous device orientation, differentiated into a gyro rate
+    DeviceTimebase timebase;      // Integration intervals from the device timestamp
+    uint8_t time_bits;            // Width and rate of the timestamps the timebase was set up for
+    uint32_t tick_hz;
+    float cursor_x, cursor_y;     // Sub-pixel motion carried to the next report
+    Zupt zupt;                    // Relative mode stillness detection and velocity high-pass
+    MotionFilter filter;          // Cursor velocity smoothing, statistics kept across resets
+    AccelCurve accel_curve;       // Gyro mode gain table, built from the config at init
+    ScrollEngine scroll;
+    uint8_t button_state;         // Last SensorPacket.button_state
+    uint8_t button_sequence;      // Last button change applied, see SensorPacket.button_sequence
+    bool button_sequence_valid;
+    uint64_t button_since_ns;     // Arrival time of the last button change
+    bool recenter_armed;          // Long press held, recenter once it lasts long enough
+    uint8_t held_back;            // MOTION_BUTTON_* down on the device but not reported yet
+    bool recenter_pending;
+    float center_yaw, center_pitch; // Orientation mapped to the middle of the screen (degrees)
+    bool center_valid;
+    int abs_x, abs_y;             // Last reported absolute position
+    bool has_position;
+    unsigned int frames;          // Processed frames, paces the debug logging
+    bool initialized;
+} MotionPipeline;
+
+// Function declarations
+void motion_pipeline_init(MotionPipeline* pipeline, const MouseConfig* pipeline_config);
+void motion_pipeline_set_calibration(MotionPipeline* pipeline, const ImuCalibration* calibration);
+void motion_pipeline_reset(MotionPipeline* pipeline, MotionReport* report);
+bool motion_pipeline_process(MotionPipeline* pipeline, const SensorSample* sample, MotionReport* report);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef SCROLL_H
+#define SCROLL_H
+
+#include "common.h"
+#include "Fusion.h"
+
+#define SCROLL_HIRES_PER_DETENT 120    // REL_WHEEL_HI_RES units per wheel click
+#define SCROLL_MIN_HIRES_STEP   8      // Smallest hi-res step emitted, keeps event rate bounded
+#define SCROLL_DETENTS_PER_G    20.0f  // Detents/s per g of tilt beyond the threshold, at sensitivity 1
+#define SCROLL_FILTER_MAX       10     // Upper bound for scroll_filter_samples
+
+// One wheel axis: moving-average tilt filter plus hi-res and legacy
+// detent accumulators
+typedef struct {
+    float history[SCROLL_FILTER_MAX];
+    float history_sum;
+    int history_len;
+    int history_pos;
+    float hires_accum;   // Sub-step remainder in hi-res units
+    int detent_accum;    // Hi-res units emitted since the last legacy detent
+} ScrollAxis;
+
+// Tilt scrolling: pitch drives the vertical wheel, roll the horizontal one
+typedef struct {
+    ScrollAxis vertical;
+    ScrollAxis horizontal;
+    bool active;         // Tilted past scroll_threshold on either axis, the cursor holds still
+} ScrollEngine;
+
+typedef struct {
+    int wheel_hi_res, hwheel_hi_res;   // REL_WHEEL_HI_RES / REL_HWHEEL_HI_RES
+    int wheel, hwheel;                 // Legacy detents for clients without hi-res support
+} ScrollOutput;
+
+// Function declarations
+void scroll_engine_reset(ScrollEngine* engine);
+bool scroll_engine_update(ScrollEngine* engine, const MouseConfig* cfg, FusionVector gravity, float dt,
+                          ScrollOutput* output);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TIMEBASE_NOMINAL_DT    0.005f // 200Hz firmware rate, used before the first interval is known
+#define TIMEBASE_MIN_DT        0.0005f
+#define TIMEBASE_MAX_DT        0.1f   // Larger device steps are treated as outliers
+#define TIMEBASE_RESYNC_S      0.25   // Host gap after which the device counter is no longer trusted
+#define TIMEBASE_STALL_S       0.05   // Device counter frozen this long -> fall back to host time
+#define TIMEBASE_DRIFT_WINDOW  5.0    // Device seconds per drift estimate
+#define TIMEBASE_DRIFT_LIMIT   0.02   // Maximum tolerated clock rate error (2%)
+
+// Converts a wrapping device tick counter into integration intervals,
+// corrected for drift between the device and host clocks.
+typedef struct {
+    uint32_t tick_hz;      // Device counter rate (1000 for millisecond timestamps)
+    uint32_t wrap_mask;    // Counter width (0xFFFF for 16-bit timestamps)
+    uint32_t last_ticks;
+    uint64_t last_host_ns;
+    uint64_t last_advance_ns; // Host time the device counter last moved
+    double drift;             // Host seconds per device second
+    double window_device_s;   // Device time covered by the drift estimation window
+    uint64_t window_start_ns;
+    uint32_t outliers;        // Intervals clamped or replaced by host time
+    bool host_fallback;
+    bool initialized;
+} DeviceTimebase;
+
+// Function declarations
+void timebase_init(DeviceTimebase* tb, uint32_t tick_hz, unsigned int counter_bits);
+float timebase_update(DeviceTimebase* tb, uint32_t device_ticks, uint64_t host_ns);
+
+#endif
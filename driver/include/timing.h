@@ -0,0 +1,23 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+
+#define LATENCY_BUCKET_US 50   // Histogram resolution
+#define LATENCY_BUCKETS   1000 // 50 us * 1000 = 50 ms range, last bucket holds overflows
+
+typedef struct {
+    uint32_t buckets[LATENCY_BUCKETS + 1];
+    uint32_t count;
+    uint64_t max_ns;
+} LatencyHistogram;
+
+// Function declarations
+uint64_t monotonic_ns();
+uint64_t process_cpu_ns();
+void latency_histogram_reset(LatencyHistogram* hist);
+void latency_histogram_record(LatencyHistogram* hist, uint64_t latency_ns);
+double latency_histogram_percentile_ms(const LatencyHistogram* hist, double percentile);
+void latency_histogram_log(const LatencyHistogram* hist, const char* label);
+
+#endif
@@ -3,18 +3,39 @@
 
 #include <linux/uinput.h>
 #include "common.h"
+#include "pipeline.h"
 
 #define VENDOR_ID  0x045E
 #define PRODUCT_ID 0x0823
 
+// Enough for every button change of a report (release and press, each with
+// its SYN_REPORT) plus a pointer/wheel report
+#define INPUT_FRAME_MAX_EVENTS (MOTION_BUTTON_CHANGES * 4 + 16)
+
+// Events collected on the stack and submitted together
+typedef struct {
+    struct input_event events[INPUT_FRAME_MAX_EVENTS];
+    unsigned int count;
+} InputFrame;
+
+typedef struct {
+    uint32_t writes;    // write() syscalls issued
+    uint32_t events;    // input_events delivered
+    uint64_t bytes;
+    uint32_t failed;    // Writes the kernel rejected or truncated
+} UInputStats;
+
 typedef struct {
     int fd;
     bool initialized;
+    UInputStats stats;
+    uint64_t stats_start_ns;
 } UInputDevice;
 
 // Function declarations
-int init_uinput_device(UInputDevice* device);
-void process_sensor_data(UInputDevice* device, const SensorPacket* packet);
+int init_uinput_device(UInputDevice* device, const char* name, bool absolute);
+void emit_motion_report(UInputDevice* device, const MotionReport* report);
+void uinput_log_stats(UInputDevice* device, const char* label);
 void cleanup_uinput_device(UInputDevice* device);
 
 #endif
@@ -0,0 +1,37 @@
+#ifndef ZUPT_H
+#define ZUPT_H
+
+#include <stdbool.h>
+#include "common.h"
+#include "Fusion.h"
+
+#define ZUPT_WINDOW 32  // Samples in the accel variance window, ~160 ms at 200 Hz
+
+// Variance over the last ZUPT_WINDOW values, updated in O(1) by adding the
+// newest value to the running sums and removing the one it replaces
+typedef struct {
+    float values[ZUPT_WINDOW];
+    unsigned int head;
+    unsigned int count;
+    double sum, sum_sq;
+} RunningVariance;
+
+// Stillness detection and drift suppression for relative mode: while the
+// device is still the cursor velocity is forced to zero, and a short
+// high-pass removes whatever constant acceleration bias is left
+typedef struct {
+    RunningVariance accel;        // Accelerometer magnitude (g)
+    bool still;
+    float highpass_in[2];         // Previous input and output per axis
+    float highpass_out[2];
+} Zupt;
+
+// Function declarations
+void running_variance_reset(RunningVariance* rv);
+void running_variance_push(RunningVariance* rv, float value);
+float running_variance_get(const RunningVariance* rv);
+void zupt_init(Zupt* zupt);
+bool zupt_update(Zupt* zupt, const MouseConfig* cfg, FusionVector gyroscope, FusionVector accelerometer);
+void zupt_filter_velocity(Zupt* zupt, const MouseConfig* cfg, float* vel_x, float* vel_y, float dt);
+
+#endif
@@ -0,0 +1,129 @@
+#include "sample_codec.h"
+#include <string.h>
+
+static size_t put_varint(uint8_t* out, uint32_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+// Returns false on truncated input or more than 32 bits. The fifth byte
+// only has room for the top four bits of the value.
+static bool get_varint(SampleDecoder* decoder, uint32_t* value) {
+    uint32_t result = 0;
+    for (unsigned int shift = 0; shift < 35; shift += 7) {
+        if (decoder->position >= decoder->length) return false;
+        uint8_t byte = decoder->data[decoder->position++];
+        if (shift == 28 && (byte & 0x70)) return false;
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Interleaves signed values so small magnitudes of either sign stay short:
+// 0, -1, 1, -2 ... become 0, 1, 2, 3 ...
+static uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static void reset_previous(CodecSample* previous, uint32_t base_timestamp_us) {
+    memset(previous, 0, sizeof(*previous));
+    previous->timestamp_us = base_timestamp_us;
+}
+
+void sample_encoder_init(SampleEncoder* encoder, uint8_t* buffer, size_t capacity, uint32_t base_timestamp_us) {
+    encoder->buffer = buffer;
+    encoder->capacity = capacity;
+    encoder->length = 0;
+    encoder->count = 0;
+    reset_previous(&encoder->previous, base_timestamp_us);
+}
+
+// Whether a further sample is guaranteed to fit
+bool sample_encoder_has_room(const SampleEncoder* encoder) {
+    return encoder->capacity - encoder->length >= SAMPLE_CODEC_MAX_SAMPLE_SIZE;
+}
+
+// Appends one sample. Returns false, leaving the block unchanged, when it
+// might not fit.
+bool sample_encoder_add(SampleEncoder* encoder, const CodecSample* sample) {
+    if (!sample_encoder_has_room(encoder)) return false;
+
+    uint8_t* out = encoder->buffer + encoder->length;
+    size_t n = put_varint(out, sample->timestamp_us - encoder->previous.timestamp_us);
+    for (int i = 0; i < 3; i++) {
+        n += put_varint(out + n, zigzag((int32_t)sample->accel[i] - encoder->previous.accel[i]));
+    }
+    for (int i = 0; i < 3; i++) {
+        n += put_varint(out + n, zigzag((int32_t)sample->gyro[i] - encoder->previous.gyro[i]));
+    }
+
+    encoder->length += n;
+    encoder->count++;
+    encoder->previous = *sample;
+    return true;
+}
+
+void sample_decoder_init(SampleDecoder* decoder, const uint8_t* data, size_t length, uint32_t base_timestamp_us) {
+    decoder->data = data;
+    decoder->length = length;
+    decoder->position = 0;
+    reset_previous(&decoder->previous, base_timestamp_us);
+}
+
+// Largest zigzag difference between two int16 readings
+#define MAX_DELTA 0x1FFFFu
+
+static bool get_sample(SampleDecoder* decoder, uint32_t* step, uint32_t* delta) {
+    if (!get_varint(decoder, step)) return false;
+    for (int i = 0; i < 6; i++) {
+        if (!get_varint(decoder, &delta[i]) || delta[i] > MAX_DELTA) return false;
+    }
+    return true;
+}
+
+// Decodes the next sample. Returns false at the end of the block or on
+// malformed input; sample_decoder_done() tells the two apart.
+bool sample_decoder_next(SampleDecoder* decoder, CodecSample* sample) {
+    size_t start = decoder->position;
+    uint32_t step, delta[6];
+    if (!get_sample(decoder, &step, delta)) {
+        decoder->position = start;
+        return false;
+    }
+
+    CodecSample next;
+    next.timestamp_us = decoder->previous.timestamp_us + step;
+    for (int i = 0; i < 3; i++) {
+        int32_t accel = decoder->previous.accel[i] + unzigzag(delta[i]);
+        int32_t gyro = decoder->previous.gyro[i] + unzigzag(delta[3 + i]);
+        if (accel < INT16_MIN || accel > INT16_MAX || gyro < INT16_MIN || gyro > INT16_MAX) {
+            decoder->position = start;
+            return false;
+        }
+        next.accel[i] = (int16_t)accel;
+        next.gyro[i] = (int16_t)gyro;
+    }
+
+    decoder->previous = next;
+    *sample = next;
+    return true;
+}
+
+// Every byte of the block was consumed by whole samples. A malformed sample
+// is not consumed, so this stays false after one.
+bool sample_decoder_done(const SampleDecoder* decoder) {
+    return decoder->position == decoder->length;
+}
@@ -0,0 +1,66 @@
+#ifndef SAMPLE_CODEC_H
+#define SAMPLE_CODEC_H
+
+// Delta/zigzag-varint coding of raw IMU readings, shared by the firmware
+// (encoder) and the driver (decoder). Plain C without allocation so both
+// sides build the same file.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SAMPLE_CODEC_DELTA_VARINT 1 // SampleBlockHeader.encoding
+
+// Worst case for one sample: a 32-bit time step (5 bytes) and six 17-bit
+// zigzag deltas (3 bytes each). Typical samples take 7-10 bytes.
+#define SAMPLE_CODEC_MAX_SAMPLE_SIZE (5 + 6 * 3)
+
+// Describes the coded samples that follow it
+typedef struct {
+    uint8_t encoding;          // SAMPLE_CODEC_DELTA_VARINT
+    uint8_t accel_range_g;     // Accelerometer full scale: an LSB is accel_range_g / 32768 g
+    uint16_t gyro_range_dps;   // Gyroscope full scale: an LSB is gyro_range_dps / 32768 deg/s
+} __attribute__((packed)) SampleBlockHeader;
+
+// One reading in sensor LSBs
+typedef struct {
+    int16_t accel[3];
+    int16_t gyro[3];
+    uint32_t timestamp_us;
+} CodecSample;
+
+// Each sample is coded against the previous one: the time step as an
+// unsigned varint, then the six channel differences as zigzag varints. The
+// first sample is coded against zero and the block's base timestamp.
+typedef struct {
+    uint8_t* buffer;
+    size_t capacity;
+    size_t length;
+    unsigned int count;
+    CodecSample previous;
+} SampleEncoder;
+
+typedef struct {
+    const uint8_t* data;
+    size_t length;
+    size_t position;
+    CodecSample previous;
+} SampleDecoder;
+
+// Function declarations
+void sample_encoder_init(SampleEncoder* encoder, uint8_t* buffer, size_t capacity, uint32_t base_timestamp_us);
+bool sample_encoder_add(SampleEncoder* encoder, const CodecSample* sample);
+bool sample_encoder_has_room(const SampleEncoder* encoder);
+void sample_decoder_init(SampleDecoder* decoder, const uint8_t* data, size_t length, uint32_t base_timestamp_us);
+bool sample_decoder_next(SampleDecoder* decoder, CodecSample* sample);
+bool sample_decoder_done(const SampleDecoder* decoder);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
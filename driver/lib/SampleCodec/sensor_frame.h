@@ -0,0 +1,10 @@
+#ifndef SENSOR_FRAME_H
+#define SENSOR_FRAME_H
+
+// Frame limits shared by the firmware (sender) and the driver (receiver),
+// so both size their buffers for the same largest notification
+
+#define BUTTON_EVENT_HISTORY     4   // Latest button changes repeated in every frame (2 bytes each)
+#define SENSOR_FRAME_MAX_SAMPLES 30  // (512 - 3 - 8 header - 8 history) / 16
+
+#endif
@@ -0,0 +1,55 @@
+#include "accel_curve.h"
+#include <math.h>
+
+// Gain at one speed for the configured profile. Only used to fill the table.
+static float profile_gain(const MouseConfig* cfg, float speed) {
+    float threshold = cfg->accel_threshold > 0.0f ? cfg->accel_threshold : 1.0f;
+    float max_gain = cfg->accel_max_gain > 0.0f ? cfg->accel_max_gain : 1.0f;
+    float gain;
+
+    switch (cfg->accel_profile) {
+        case ACCEL_PROFILE_LINEAR:
+            // 1:1 up to the threshold, then rising linearly
+            gain = speed <= threshold ? 1.0f : 1.0f + (speed - threshold) / threshold;
+            break;
+        case ACCEL_PROFILE_POWER:
+            // Output speed grows as speed^exponent: below the threshold the
+            // gain drops under 1 for fine control
+            gain = powf(fmaxf(speed, 0.001f) / threshold, cfg->accel_exponent - 1.0f);
+            break;
+        case ACCEL_PROFILE_ADAPTIVE:
+            // Shaped after libinput's adaptive profile: decelerate slow
+            // motion, flat around the threshold, then a linear incline
+            if (speed < threshold * 0.5f) {
+                gain = 0.3f + 1.4f * speed / threshold;
+            } else if (speed <= threshold) {
+                gain = 1.0f;
+            } else {
+                gain = 1.0f + 1.1f * (speed - threshold) / threshold;
+            }
+            break;
+        case ACCEL_PROFILE_FLAT:
+        default:
+            gain = 1.0f;
+            break;
+    }
+
+    return gain > max_gain ? max_gain : gain;
+}
+
+void accel_curve_build(AccelCurve* curve, const MouseConfig* cfg) {
+    curve->step = ACCEL_CURVE_MAX_SPEED / ACCEL_CURVE_SIZE;
+    for (int i = 0; i <= ACCEL_CURVE_SIZE; i++) {
+        curve->gain[i] = profile_gain(cfg, i * curve->step);
+    }
+}
+
+float accel_curve_gain(const AccelCurve* curve, float speed) {
+    float position = speed / curve->step;
+    if (position >= ACCEL_CURVE_SIZE) return curve->gain[ACCEL_CURVE_SIZE];
+    if (position <= 0.0f) return curve->gain[0];
+
+    int index = (int)position;
+    float fraction = position - index;
+    return curve->gain[index] + (curve->gain[index + 1] - curve->gain[index]) * fraction;
+}
@@ -0,0 +1,242 @@
+#define _GNU_SOURCE
+#include "async_log.h"
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "timing.h"
+
+#define ASYNC_LOG_LATE_NS  100000000ULL // Note records that waited longer than this
+
+typedef struct {
+    uint32_t sequence;      // Slot turn: index when free, index + 1 when filled
+    uint8_t level;
+    uint8_t nargs;
+    uint64_t timestamp_ns;  // When the record was logged (CLOCK_MONOTONIC)
+    const char* format;
+    double args[ASYNC_LOG_MAX_ARGS];
+} LogRecord;
+
+// Bounded multi-producer ring with per-slot sequence numbers: producers
+// claim a slot with one CAS and never wait; the writer thread is the only
+// consumer
+static LogRecord ring[ASYNC_LOG_CAPACITY];
+static uint32_t enqueue_pos;
+static uint32_t dequeue_pos;
+static uint32_t dropped;
+
+static int runtime_level = LOG_INFO;
+static pthread_t writer_thread;
+static bool writer_running = false;
+static bool stop_requested = false;
+
+// The writer sleeps on an eventfd while the ring is empty. Producers only
+// signal it when the writer announced it is about to sleep, so a busy input
+// path does not pay a syscall per record.
+static int wake_fd = -1;
+static bool writer_waiting = false;
+
+// Render one conversion spec at a time; the arguments are doubles, so each
+// spec is rewritten for the C type its conversion expects
+static void format_record(const LogRecord* record, char* out, size_t size) {
+    const char* f = record->format;
+    size_t len = 0;
+    int arg = 0;
+
+    while (*f && len + 1 < size) {
+        if (*f != '%') {
+            out[len++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            out[len++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // Copy flags, width and precision; drop length modifiers
+        char spec[32] = "%";
+        size_t spec_len = 1;
+        f++;
+        while (*f && strchr("-+ #0123456789.", *f) && spec_len < sizeof(spec) - 5) spec[spec_len++] = *f++;
+        while (*f && strchr("hlLqjzt", *f)) f++;
+        char conversion = *f ? *f++ : '\0';
+
+        double value = arg < record->nargs ? record->args[arg] : 0.0;
+        arg++;
+
+        int written;
+        switch (conversion) {
+            case 'd': case 'i':
+                memcpy(spec + spec_len, "lld", 4);
+                written = snprintf(out + len, size - len, spec, (long long)value);
+                break;
+            case 'u': case 'x': case 'X': case 'o':
+                spec[spec_len++] = 'l';
+                spec[spec_len++] = 'l';
+                spec[spec_len++] = conversion;
+                spec[spec_len] = '\0';
+                written = snprintf(out + len, size - len, spec, (unsigned long long)value);
+                break;
+            case 'c':
+                spec[spec_len++] = 'c';
+                spec[spec_len] = '\0';
+                written = snprintf(out + len, size - len, spec, (int)value);
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                spec[spec_len++] = conversion;
+                spec[spec_len] = '\0';
+                written = snprintf(out + len, size - len, spec, value);
+                break;
+            default:
+                written = snprintf(out + len, size - len, "?");
+                break;
+        }
+        if (written < 0) break;
+        len += (size_t)written < size - len ? (size_t)written : size - len - 1;
+    }
+    out[len] = '\0';
+}
+
+static void write_record(const LogRecord* record) {
+    char message[512];
+    format_record(record, message, sizeof(message));
+
+    uint64_t age_ns = monotonic_ns() - record->timestamp_ns;
+    if (age_ns > ASYNC_LOG_LATE_NS) {
+        syslog(record->level, "%s (logged %.0f ms earlier)", message, age_ns / 1e6);
+    } else {
+        syslog(record->level, "%s", message);
+    }
+}
+
+static bool pop_record(LogRecord* out) {
+    LogRecord* slot = &ring[dequeue_pos & (ASYNC_LOG_CAPACITY - 1)];
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != dequeue_pos + 1) return false;
+
+    *out = *slot;
+    __atomic_store_n(&slot->sequence, dequeue_pos + ASYNC_LOG_CAPACITY, __ATOMIC_RELEASE);
+    dequeue_pos++;
+    return true;
+}
+
+static bool record_ready() {
+    const LogRecord* slot = &ring[dequeue_pos & (ASYNC_LOG_CAPACITY - 1)];
+    return __atomic_load_n(&slot->sequence, __ATOMIC_SEQ_CST) == dequeue_pos + 1;
+}
+
+static void wake_writer() {
+    eventfd_write(wake_fd, 1);
+}
+
+static void drain_records() {
+    LogRecord record;
+    while (pop_record(&record)) {
+        write_record(&record);
+    }
+
+    uint32_t lost = __atomic_exchange_n(&dropped, 0, __ATOMIC_RELAXED);
+    if (lost > 0) {
+        syslog(LOG_WARNING, "Log ring full, %u records dropped", lost);
+    }
+}
+
+static void* writer_main(void* arg) {
+    (void)arg;
+    struct pollfd pfd = {wake_fd, POLLIN, 0};
+
+    while (!__atomic_load_n(&stop_requested, __ATOMIC_ACQUIRE)) {
+        drain_records();
+
+        // Announce the sleep before the last look at the ring: a record
+        // published after that look sees the flag and wakes the writer
+        __atomic_store_n(&writer_waiting, true, __ATOMIC_SEQ_CST);
+        if (!record_ready() && !__atomic_load_n(&stop_requested, __ATOMIC_ACQUIRE)) {
+            poll(&pfd, 1, -1);
+            eventfd_t count;
+            eventfd_read(wake_fd, &count);
+        }
+        __atomic_store_n(&writer_waiting, false, __ATOMIC_RELAXED);
+    }
+    drain_records();
+    return NULL;
+}
+
+int async_log_start(int level) {
+    if (writer_running) return 0;
+
+    for (uint32_t i = 0; i < ASYNC_LOG_CAPACITY; i++) {
+        ring[i].sequence = i;
+    }
+    enqueue_pos = 0;
+    dequeue_pos = 0;
+    dropped = 0;
+    runtime_level = level;
+    stop_requested = false;
+    writer_waiting = false;
+
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd < 0 || pthread_create(&writer_thread, NULL, writer_main, NULL) != 0) {
+        syslog(LOG_WARNING, "Failed to start log writer thread, logging synchronously");
+        if (wake_fd >= 0) close(wake_fd);
+        wake_fd = -1;
+        return -1;
+    }
+    writer_running = true;
+    return 0;
+}
+
+// Flushes everything logged so far
+void async_log_stop() {
+    if (!writer_running) return;
+
+    __atomic_store_n(&stop_requested, true, __ATOMIC_RELEASE);
+    wake_writer();
+    pthread_join(writer_thread, NULL);
+    writer_running = false;
+    close(wake_fd);
+    wake_fd = -1;
+}
+
+void async_log_record(int level, const char* format, const double* args, int nargs) {
+    if (level > runtime_level) return;
+    if (nargs > ASYNC_LOG_MAX_ARGS) nargs = ASYNC_LOG_MAX_ARGS;
+
+    LogRecord local;
+    LogRecord* record = &local;
+    uint32_t pos = 0;
+
+    // Without the writer thread (offline tools) format in place
+    if (__atomic_load_n(&writer_running, __ATOMIC_ACQUIRE)) {
+        pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+        for (;;) {
+            record = &ring[pos & (ASYNC_LOG_CAPACITY - 1)];
+            int32_t diff = (int32_t)(__atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE) - pos);
+            if (diff == 0) {
+                if (__atomic_compare_exchange_n(&enqueue_pos, &pos, pos + 1, true,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+            } else if (diff < 0) {
+                __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+                return;
+            } else {
+                pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    record->level = (uint8_t)level;
+    record->nargs = (uint8_t)nargs;
+    record->timestamp_ns = monotonic_ns();
+    record->format = format;
+    memcpy(record->args, args, nargs * sizeof(double));
+
+    if (record == &local) {
+        write_record(record);
+    } else {
+        __atomic_store_n(&record->sequence, pos + 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&writer_waiting, __ATOMIC_SEQ_CST)) wake_writer();
+    }
+}
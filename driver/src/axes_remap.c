@@ -0,0 +1,70 @@
+#define _GNU_SOURCE
+#include "axes_remap.h"
+#include <strings.h>
+
+#define AXES_ALIGNMENTS 24
+
+#define DEFINE_REMAP(suffix) \
+    static FusionVector remap_##suffix(FusionVector sensor) { \
+        return FusionAxesSwap(sensor, FusionAxesAlignment##suffix); \
+    }
+
+DEFINE_REMAP(PXPYPZ)
+DEFINE_REMAP(PXNZPY)
+DEFINE_REMAP(PXNYNZ)
+DEFINE_REMAP(PXPZNY)
+DEFINE_REMAP(NXPYNZ)
+DEFINE_REMAP(NXPZPY)
+DEFINE_REMAP(NXNYPZ)
+DEFINE_REMAP(NXNZNY)
+DEFINE_REMAP(PYNXPZ)
+DEFINE_REMAP(PYNZNX)
+DEFINE_REMAP(PYPXNZ)
+DEFINE_REMAP(PYPZPX)
+DEFINE_REMAP(NYPXPZ)
+DEFINE_REMAP(NYNZPX)
+DEFINE_REMAP(NYNXNZ)
+DEFINE_REMAP(NYPZNX)
+DEFINE_REMAP(PZPYNX)
+DEFINE_REMAP(PZPXPY)
+DEFINE_REMAP(PZNYPX)
+DEFINE_REMAP(PZNXNY)
+DEFINE_REMAP(NZPYPX)
+DEFINE_REMAP(NZNXPY)
+DEFINE_REMAP(NZNYNX)
+DEFINE_REMAP(NZPXNY)
+
+// Indexed by FusionAxesAlignment
+static const struct {
+    const char* name;
+    AxesRemap remap;
+} alignments[AXES_ALIGNMENTS] = {
+    {"+X+Y+Z", remap_PXPYPZ}, {"+X-Z+Y", remap_PXNZPY}, {"+X-Y-Z", remap_PXNYNZ}, {"+X+Z-Y", remap_PXPZNY},
+    {"-X+Y-Z", remap_NXPYNZ}, {"-X+Z+Y", remap_NXPZPY}, {"-X-Y+Z", remap_NXNYPZ}, {"-X-Z-Y", remap_NXNZNY},
+    {"+Y-X+Z", remap_PYNXPZ}, {"+Y-Z-X", remap_PYNZNX}, {"+Y+X-Z", remap_PYPXNZ}, {"+Y+Z+X", remap_PYPZPX},
+    {"-Y+X+Z", remap_NYPXPZ}, {"-Y-Z+X", remap_NYNZPX}, {"-Y-X-Z", remap_NYNXNZ}, {"-Y+Z-X", remap_NYPZNX},
+    {"+Z+Y-X", remap_PZPYNX}, {"+Z+X+Y", remap_PZPXPY}, {"+Z-Y+X", remap_PZNYPX}, {"+Z-X-Y", remap_PZNXNY},
+    {"-Z+Y+X", remap_NZPYPX}, {"-Z-X+Y", remap_NZNXPY}, {"-Z-Y-X", remap_NZNYNX}, {"-Z+X-Y", remap_NZPXNY},
+};
+
+AxesRemap axes_remap_for(FusionAxesAlignment alignment) {
+    if ((unsigned int)alignment >= AXES_ALIGNMENTS) return remap_PXPYPZ;
+    return alignments[alignment].remap;
+}
+
+// Accepts the FusionAxes notation, e.g. "+X-Z+Y": which sensor axis lies
+// along body X, Y and Z
+bool axes_alignment_parse(const char* name, FusionAxesAlignment* alignment) {
+    for (int i = 0; i < AXES_ALIGNMENTS; i++) {
+        if (strcasecmp(name, alignments[i].name) == 0) {
+            *alignment = (FusionAxesAlignment)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* axes_alignment_name(FusionAxesAlignment alignment) {
+    if ((unsigned int)alignment >= AXES_ALIGNMENTS) return "?";
+    return alignments[alignment].name;
+}
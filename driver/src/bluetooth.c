@@ -1,5 +1,9 @@
 #define _GNU_SOURCE
 #include "bluetooth.h"
+#include "async_log.h"
+#include "timing.h"
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,10 +14,162 @@
 #include <math.h>
 
 #define BLUEZ_SERVICE "org.bluez"
+#define SCAN_TIMEOUT_MS 10000
+#define CONNECT_TIMEOUT_MS 5000
+#define SERVICES_RESOLVE_TIMEOUT_MS 5000
 
 static DBusConnection* dbus_conn = NULL;
 static char adapter_path[64] = {0};
 
+// Active discovery session, shared by every connection
+static DeviceFoundCallback discovery_callback = NULL;
+static void* discovery_user_data = NULL;
+static bool adapter_discovering = false;
+
+// D-Bus socket watches, mirrored into the daemon's epoll loop
+#define MAX_DBUS_WATCHES 8
+static EventLoop* event_loop = NULL;
+static DBusWatch* watches[MAX_DBUS_WATCHES];
+
+static uint32_t watch_epoll_events(int fd) {
+    uint32_t events = 0;
+    for (int i = 0; i < MAX_DBUS_WATCHES; i++) {
+        if (!watches[i] || dbus_watch_get_unix_fd(watches[i]) != fd || !dbus_watch_get_enabled(watches[i]))
+            continue;
+        unsigned int flags = dbus_watch_get_flags(watches[i]);
+        if (flags & DBUS_WATCH_READABLE) events |= EPOLLIN;
+        if (flags & DBUS_WATCH_WRITABLE) events |= EPOLLOUT;
+    }
+    return events;
+}
+
+static void dbus_fd_ready(int fd, uint32_t events, void* user_data) {
+    (void)user_data;
+
+    unsigned int flags = 0;
+    if (events & EPOLLIN) flags |= DBUS_WATCH_READABLE;
+    if (events & EPOLLOUT) flags |= DBUS_WATCH_WRITABLE;
+    if (events & EPOLLERR) flags |= DBUS_WATCH_ERROR;
+    if (events & EPOLLHUP) flags |= DBUS_WATCH_HANGUP;
+
+    // dbus_watch_handle() may add or remove watches, so work on a snapshot
+    DBusWatch* ready[MAX_DBUS_WATCHES];
+    memcpy(ready, watches, sizeof(ready));
+
+    for (int i = 0; i < MAX_DBUS_WATCHES; i++) {
+        if (!ready[i] || dbus_watch_get_unix_fd(ready[i]) != fd || !dbus_watch_get_enabled(ready[i]))
+            continue;
+        unsigned int wanted = dbus_watch_get_flags(ready[i]) | DBUS_WATCH_ERROR | DBUS_WATCH_HANGUP;
+        if (flags & wanted) dbus_watch_handle(ready[i], flags & wanted);
+    }
+}
+
+// Re-register an fd with the union of its enabled watch conditions
+static void sync_watch_fd(int fd) {
+    if (!event_loop) return;
+
+    uint32_t events = watch_epoll_events(fd);
+    if (events == 0) {
+        event_loop_remove(event_loop, fd);
+    } else if (event_loop_modify(event_loop, fd, events) < 0) {
+        event_loop_add(event_loop, fd, events, dbus_fd_ready, NULL);
+    }
+}
+
+static dbus_bool_t add_watch(DBusWatch* watch, void* data) {
+    (void)data;
+    for (int i = 0; i < MAX_DBUS_WATCHES; i++) {
+        if (!watches[i]) {
+            watches[i] = watch;
+            sync_watch_fd(dbus_watch_get_unix_fd(watch));
+            return TRUE;
+        }
+    }
+    syslog(LOG_ERR, "Too many D-Bus watches");
+    return FALSE;
+}
+
+static void remove_watch(DBusWatch* watch, void* data) {
+    (void)data;
+    for (int i = 0; i < MAX_DBUS_WATCHES; i++) {
+        if (watches[i] == watch) {
+            watches[i] = NULL;
+            sync_watch_fd(dbus_watch_get_unix_fd(watch));
+            return;
+        }
+    }
+}
+
+static void toggle_watch(DBusWatch* watch, void* data) {
+    (void)data;
+    sync_watch_fd(dbus_watch_get_unix_fd(watch));
+}
+
+// D-Bus timeouts as timerfds in the same loop, so replies that never come
+// (a Connect to a controller out of range) fail on time without blocking
+#define MAX_DBUS_TIMEOUTS (MAX_DEVICES + 8) // A pending call per connecting device, plus blocking calls
+static DBusTimeout* timeouts[MAX_DBUS_TIMEOUTS];
+static int timeout_fds[MAX_DBUS_TIMEOUTS];
+
+static void dbus_timeout_ready(int fd, uint32_t events, void* user_data) {
+    (void)fd;
+    (void)events;
+    dbus_timeout_handle(user_data);
+}
+
+static void disarm_timeout(int slot) {
+    if (timeout_fds[slot] < 0) return;
+    event_loop_remove(event_loop, timeout_fds[slot]);
+    close(timeout_fds[slot]);
+    timeout_fds[slot] = -1;
+}
+
+static bool arm_timeout(int slot) {
+    DBusTimeout* timeout = timeouts[slot];
+    if (!dbus_timeout_get_enabled(timeout)) return true;
+
+    int interval = dbus_timeout_get_interval(timeout);
+    timeout_fds[slot] = event_loop_add_timer(event_loop, interval > 0 ? interval : 1, dbus_timeout_ready, timeout);
+    return timeout_fds[slot] >= 0;
+}
+
+static dbus_bool_t add_timeout(DBusTimeout* timeout, void* data) {
+    (void)data;
+    for (int i = 0; i < MAX_DBUS_TIMEOUTS; i++) {
+        if (!timeouts[i]) {
+            timeouts[i] = timeout;
+            timeout_fds[i] = -1;
+            if (arm_timeout(i)) return TRUE;
+            timeouts[i] = NULL;
+            return FALSE;
+        }
+    }
+    syslog(LOG_ERR, "Too many D-Bus timeouts");
+    return FALSE;
+}
+
+static void remove_timeout(DBusTimeout* timeout, void* data) {
+    (void)data;
+    for (int i = 0; i < MAX_DBUS_TIMEOUTS; i++) {
+        if (timeouts[i] == timeout) {
+            disarm_timeout(i);
+            timeouts[i] = NULL;
+            return;
+        }
+    }
+}
+
+static void toggle_timeout(DBusTimeout* timeout, void* data) {
+    (void)data;
+    for (int i = 0; i < MAX_DBUS_TIMEOUTS; i++) {
+        if (timeouts[i] == timeout) {
+            disarm_timeout(i);
+            arm_timeout(i);
+            return;
+        }
+    }
+}
+
 // Simplified D-Bus method call with better error handling
 static int call_dbus_method(const char* path, const char* interface, const char* method) {
     DBusMessage* msg = dbus_message_new_method_call(BLUEZ_SERVICE, path, interface, method);
@@ -38,6 +194,35 @@ static int call_dbus_method(const char* path, const char* interface, const char*
     return result;
 }
 
+static DBusMessage* get_property_message(const char* path, const char* interface, const char* property) {
+    DBusMessage* msg = dbus_message_new_method_call(
+        BLUEZ_SERVICE, path, "org.freedesktop.DBus.Properties", "Get");
+    if (!msg) return NULL;
+
+    DBusMessageIter iter;
+    dbus_message_iter_init_append(msg, &iter);
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &interface);
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &property);
+    return msg;
+}
+
+// Properties.Get; on success returns the reply (caller unrefs) with
+// variant positioned on the value
+static DBusMessage* get_property(const char* path, const char* interface, const char* property,
+                                 DBusMessageIter* variant) {
+    DBusMessage* msg = get_property_message(path, interface, property);
+    if (!msg) return NULL;
+
+    DBusMessage* reply = dbus_connection_send_with_reply_and_block(dbus_conn, msg, 5000, NULL);
+    dbus_message_unref(msg);
+    if (!reply) return NULL;
+
+    DBusMessageIter reply_iter;
+    dbus_message_iter_init(reply, &reply_iter);
+    dbus_message_iter_recurse(&reply_iter, variant);
+    return reply;
+}
+
 // Find first powered Bluetooth adapter
 static int find_bluetooth_adapter() {
     DBusMessage* msg = dbus_message_new_method_call(
@@ -146,8 +331,92 @@ static int set_adapter_powered(bool powered) {
     return result;
 }
 
-// Simplified device finder
-static bool find_m5_device(BLEConnection* conn) {
+static bool is_m5_name(const char* name) {
+    return name && (strstr(name, "M5") || strstr(name, "Mouse"));
+}
+
+// Check a Device1 property dict (a{sv}) for our name pattern or service UUID.
+// Works on full dicts from GetManagedObjects/InterfacesAdded as well as the
+// partial ones in PropertiesChanged. The Name, if present, is copied out.
+static bool device_properties_match(DBusMessageIter* props, char* name, size_t name_size) {
+    DBusMessageIter dict_iter, entry_iter, variant_iter, uuid_iter;
+    bool matched = false;
+
+    dbus_message_iter_recurse(props, &dict_iter);
+    while (dbus_message_iter_get_arg_type(&dict_iter) == DBUS_TYPE_DICT_ENTRY) {
+        dbus_message_iter_recurse(&dict_iter, &entry_iter);
+
+        char* prop_name;
+        dbus_message_iter_get_basic(&entry_iter, &prop_name);
+        dbus_message_iter_next(&entry_iter);
+        dbus_message_iter_recurse(&entry_iter, &variant_iter);
+
+        if (strcmp(prop_name, "Name") == 0 && dbus_message_iter_get_arg_type(&variant_iter) == DBUS_TYPE_STRING) {
+            char* value;
+            dbus_message_iter_get_basic(&variant_iter, &value);
+            strncpy(name, value, name_size - 1);
+            name[name_size - 1] = '\0';
+            if (is_m5_name(value)) matched = true;
+        } else if (strcmp(prop_name, "UUIDs") == 0 && dbus_message_iter_get_arg_type(&variant_iter) == DBUS_TYPE_ARRAY) {
+            dbus_message_iter_recurse(&variant_iter, &uuid_iter);
+            while (dbus_message_iter_get_arg_type(&uuid_iter) == DBUS_TYPE_STRING) {
+                char* uuid;
+                dbus_message_iter_get_basic(&uuid_iter, &uuid);
+                if (strcasecmp(uuid, SERVICE_UUID) == 0) matched = true;
+                dbus_message_iter_next(&uuid_iter);
+            }
+        }
+
+        dbus_message_iter_next(&dict_iter);
+    }
+
+    return matched;
+}
+
+static bool is_adapter_device_path(const char* path) {
+    return path && strstr(path, adapter_path) == path && strstr(path, "/dev_");
+}
+
+// BlueZ device paths end in dev_AA_BB_CC_DD_EE_FF
+static void address_from_path(const char* path, char* address, size_t address_size) {
+    const char* dev = strstr(path, "/dev_");
+    snprintf(address, address_size, "%s", dev ? dev + 5 : "");
+    for (char* c = address; *c; c++) {
+        if (*c == '_') *c = ':';
+    }
+}
+
+static void report_device(const char* path, const char* name) {
+    if (!discovery_callback) return;
+
+    char address[18];
+    address_from_path(path, address, sizeof(address));
+    discovery_callback(path, name, address, discovery_user_data);
+}
+
+// Walk an interfaces dict (a{sa{sv}}) and match its Device1 properties
+static bool interfaces_match(DBusMessageIter* interfaces, char* name, size_t name_size) {
+    DBusMessageIter iface_dict_iter, iface_entry_iter;
+
+    dbus_message_iter_recurse(interfaces, &iface_dict_iter);
+    while (dbus_message_iter_get_arg_type(&iface_dict_iter) == DBUS_TYPE_DICT_ENTRY) {
+        dbus_message_iter_recurse(&iface_dict_iter, &iface_entry_iter);
+
+        char* interface;
+        dbus_message_iter_get_basic(&iface_entry_iter, &interface);
+        if (strcmp(interface, "org.bluez.Device1") == 0) {
+            dbus_message_iter_next(&iface_entry_iter);
+            return device_properties_match(&iface_entry_iter, name, name_size);
+        }
+
+        dbus_message_iter_next(&iface_dict_iter);
+    }
+    return false;
+}
+
+// Report every matching device among the objects BlueZ already knows, using
+// the properties carried in the GetManagedObjects reply
+static bool find_m5_devices() {
     DBusMessage* msg = dbus_message_new_method_call(
         BLUEZ_SERVICE, "/", "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
     if (!msg) {
@@ -162,56 +431,23 @@ static bool find_m5_device(BLEConnection* conn) {
         return false;
     }
 
-    syslog(LOG_INFO, "Got BlueZ managed objects, scanning for devices...");
-
     DBusMessageIter iter, dict_iter, entry_iter;
     dbus_message_iter_init(reply, &iter);
     dbus_message_iter_recurse(&iter, &dict_iter);
 
     bool found = false;
-    while (dbus_message_iter_get_arg_type(&dict_iter) == DBUS_TYPE_DICT_ENTRY && !found) {
+    while (dbus_message_iter_get_arg_type(&dict_iter) == DBUS_TYPE_DICT_ENTRY) {
         dbus_message_iter_recurse(&dict_iter, &entry_iter);
 
         char* path;
         dbus_message_iter_get_basic(&entry_iter, &path);
 
-        // Only check device paths for our adapter
-        if (strstr(path, adapter_path) && strstr(path, "/dev_")) {
-            // Get device name property
-            DBusMessage* prop_msg = dbus_message_new_method_call(
-                BLUEZ_SERVICE, path, "org.freedesktop.DBus.Properties", "Get");
-            if (prop_msg) {
-                const char* interface = "org.bluez.Device1";
-                const char* property = "Name";
-
-                DBusMessageIter prop_iter;
-                dbus_message_iter_init_append(prop_msg, &prop_iter);
-                dbus_message_iter_append_basic(&prop_iter, DBUS_TYPE_STRING, &interface);
-                dbus_message_iter_append_basic(&prop_iter, DBUS_TYPE_STRING, &property);
-
-                DBusMessage* prop_reply = dbus_connection_send_with_reply_and_block(
-                    dbus_conn, prop_msg, 5000, NULL);
-                dbus_message_unref(prop_msg);
-
-                if (prop_reply) {
-                    DBusMessageIter reply_iter, variant_iter;
-                    dbus_message_iter_init(prop_reply, &reply_iter);
-                    dbus_message_iter_recurse(&reply_iter, &variant_iter);
-
-                    if (dbus_message_iter_get_arg_type(&variant_iter) == DBUS_TYPE_STRING) {
-                        char* name;
-                        dbus_message_iter_get_basic(&variant_iter, &name);
-
-                        syslog(LOG_INFO, "Found device: %s at path %s", name ? name : "NULL", path);
-                        if (name && (strstr(name, "M5") || strstr(name, "Mouse"))) {
-                            strncpy(conn->device_path, path, sizeof(conn->device_path) - 1);
-                            strncpy(conn->device_name, name, sizeof(conn->device_name) - 1);
-                            found = true;
-                            syslog(LOG_INFO, "Found M5 device: %s", name);
-                        }
-                    }
-                    dbus_message_unref(prop_reply);
-                }
+        if (is_adapter_device_path(path)) {
+            char name[128] = {0};
+            dbus_message_iter_next(&entry_iter);
+            if (interfaces_match(&entry_iter, name, sizeof(name))) {
+                report_device(path, name);
+                found = true;
             }
         }
 
@@ -222,6 +458,43 @@ static bool find_m5_device(BLEConnection* conn) {
     return found;
 }
 
+// Picks up devices as BlueZ reports them during discovery
+static DBusHandlerResult discovery_handler(DBusConnection* bus, DBusMessage* msg, void* user_data) {
+    (void)bus;
+    (void)user_data;
+    const char* path = NULL;
+    char name[128] = {0};
+    bool matched = false;
+    DBusMessageIter iter;
+
+    if (!dbus_message_iter_init(msg, &iter)) {
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+    }
+
+    if (dbus_message_is_signal(msg, "org.freedesktop.DBus.ObjectManager", "InterfacesAdded")) {
+        // (o path, a{sa{sv}} interfaces)
+        dbus_message_iter_get_basic(&iter, &path);
+        if (is_adapter_device_path(path) && dbus_message_iter_next(&iter)) {
+            matched = interfaces_match(&iter, name, sizeof(name));
+        }
+    } else if (dbus_message_is_signal(msg, "org.freedesktop.DBus.Properties", "PropertiesChanged")) {
+        // (s interface, a{sv} changed, as invalidated); Name/UUIDs often
+        // resolve after the object was first added
+        char* interface;
+        path = dbus_message_get_path(msg);
+        dbus_message_iter_get_basic(&iter, &interface);
+        if (strcmp(interface, "org.bluez.Device1") == 0 && is_adapter_device_path(path) &&
+            dbus_message_iter_next(&iter)) {
+            matched = device_properties_match(&iter, name, sizeof(name));
+        }
+    }
+
+    if (matched) {
+        report_device(path, name);
+    }
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
 int init_bluetooth() {
     syslog(LOG_INFO, "Initializing Bluetooth");
 
@@ -248,32 +521,318 @@ int init_bluetooth() {
     return 0;
 }
 
-int scan_for_device(BLEConnection* conn) {
-    if (!conn || !dbus_conn) return -1;
+// Drive the D-Bus connection from the caller's epoll loop instead of polling
+int bluetooth_attach_event_loop(EventLoop* loop) {
+    if (!dbus_conn || !loop) return -1;
 
-    syslog(LOG_INFO, "Scanning for M5 device...");
+    event_loop = loop;
+    if (!dbus_connection_set_watch_functions(dbus_conn, add_watch, remove_watch, toggle_watch, NULL, NULL) ||
+        !dbus_connection_set_timeout_functions(dbus_conn, add_timeout, remove_timeout, toggle_timeout, NULL, NULL)) {
+        syslog(LOG_ERR, "Failed to install D-Bus watch functions");
+        dbus_connection_set_watch_functions(dbus_conn, NULL, NULL, NULL, NULL, NULL);
+        event_loop = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+#define DISCOVERY_MATCH_ADDED \
+    "type='signal',sender='org.bluez',interface='org.freedesktop.DBus.ObjectManager',member='InterfacesAdded'"
+#define DISCOVERY_MATCH_CHANGED \
+    "type='signal',sender='org.bluez',interface='org.freedesktop.DBus.Properties'," \
+    "member='PropertiesChanged',arg0='org.bluez.Device1'"
+
+// Dispatch every message libdbus has buffered. Handlers run synchronously,
+// so notification data reaches each connection's consumer from here.
+// Returns whether there was anything to dispatch.
+bool bluetooth_dispatch() {
+    if (!dbus_conn) return false;
+    bool dispatched = false;
+    while (dbus_connection_get_dispatch_status(dbus_conn) == DBUS_DISPATCH_DATA_REMAINS) {
+        dbus_connection_dispatch(dbus_conn);
+        dispatched = true;
+    }
+    return dispatched;
+}
+
+// Service the event loop (or the bare bus without one) while waiting
+static int pump_events(int timeout_ms) {
+    int result = 0;
+    if (event_loop) {
+        result = event_loop_run_once(event_loop, timeout_ms);
+    } else {
+        dbus_connection_read_write(dbus_conn, timeout_ms);
+    }
+    bluetooth_dispatch();
+    return result;
+}
+
+// Report matching devices to the callback until stop_discovery(): first
+// the ones BlueZ already knows, then as InterfacesAdded/PropertiesChanged
+// announce them. The callback runs from bluetooth_dispatch() and must not
+// block or dispatch itself.
+int start_discovery(DeviceFoundCallback callback, void* user_data) {
+    if (!dbus_conn || !callback) return -1;
+    if (discovery_callback) stop_discovery();
+
+    // Subscribe before listing objects so nothing slips in between
+    dbus_bus_add_match(dbus_conn, DISCOVERY_MATCH_ADDED, NULL);
+    dbus_bus_add_match(dbus_conn, DISCOVERY_MATCH_CHANGED, NULL);
+    dbus_connection_add_filter(dbus_conn, discovery_handler, NULL, NULL);
+    discovery_callback = callback;
+    discovery_user_data = user_data;
 
-    // Start discovery
     if (call_dbus_method(adapter_path, "org.bluez.Adapter1", "StartDiscovery") != 0) {
         syslog(LOG_ERR, "Failed to start discovery");
-        return -1;
+    } else {
+        adapter_discovering = true;
     }
 
+    find_m5_devices();
+    return 0;
+}
+
+void stop_discovery() {
+    if (!dbus_conn || !discovery_callback) return;
+
+    dbus_connection_remove_filter(dbus_conn, discovery_handler, NULL);
+    dbus_bus_remove_match(dbus_conn, DISCOVERY_MATCH_ADDED, NULL);
+    dbus_bus_remove_match(dbus_conn, DISCOVERY_MATCH_CHANGED, NULL);
+    discovery_callback = NULL;
+    discovery_user_data = NULL;
+
+    if (adapter_discovering) {
+        call_dbus_method(adapter_path, "org.bluez.Adapter1", "StopDiscovery");
+        adapter_discovering = false;
+    }
+}
+
+static void scan_device_found(const char* device_path, const char* name, const char* address, void* user_data) {
+    (void)address;
+    BLEConnection* conn = user_data;
+    if (conn->device_path[0]) return;
+
+    snprintf(conn->device_path, sizeof(conn->device_path), "%s", device_path);
+    snprintf(conn->device_name, sizeof(conn->device_name), "%s", name[0] ? name : "M5 device");
+    syslog(LOG_INFO, "Found M5 device: %s at path %s", conn->device_name, device_path);
+}
+
+// Single-device convenience: returns as soon as the first matching device
+// is known to BlueZ, or after SCAN_TIMEOUT_MS
+int scan_for_device(BLEConnection* conn) {
+    if (!conn || !dbus_conn) return -1;
+
+    syslog(LOG_INFO, "Scanning for M5 device...");
+    memset(conn->device_path, 0, sizeof(conn->device_path));
+
     conn->scanning = true;
-    syslog(LOG_INFO, "Discovery started, scanning for 10 seconds...");
-    sleep(10);  // Increased scan duration
+    start_discovery(scan_device_found, conn);
 
-    // Find device
-    bool found = find_m5_device(conn);
+    if (!conn->device_path[0] && adapter_discovering) {
+        syslog(LOG_INFO, "Discovery started, waiting up to %d seconds...", SCAN_TIMEOUT_MS / 1000);
 
-    // Stop discovery
-    call_dbus_method(adapter_path, "org.bluez.Adapter1", "StopDiscovery");
+        uint64_t deadline = monotonic_ns() + SCAN_TIMEOUT_MS * 1000000ULL;
+        while (running && !conn->device_path[0]) {
+            uint64_t now = monotonic_ns();
+            if (now >= deadline) break;
+            if (pump_events((int)((deadline - now) / 1000000ULL) + 1) < 0) break;
+        }
+    }
+
+    stop_discovery();
     conn->scanning = false;
 
-    return found ? 0 : -1;
+    return conn->device_path[0] ? 0 : -1;
+}
+
+// Legacy SensorPacket scaling: acceleration * 100, rotation * 10
+static void unpack_readings(SensorSample* slot) {
+    const SensorPacket* packet = &slot->packet;
+    slot->accelerometer = (FusionVector){.axis = {packet->accel_x / 100.0f, packet->accel_y / 100.0f,
+                                                  packet->accel_z / 100.0f}};
+    slot->gyroscope = (FusionVector){.axis = {packet->gyro_x / 10.0f, packet->gyro_y / 10.0f,
+                                              packet->gyro_z / 10.0f}};
+}
+
+static void track_sequence(BLEConnection* conn, uint16_t sequence) {
+    if (conn->sequence_valid && sequence != conn->next_sequence) {
+        conn->frames_lost += (uint16_t)(sequence - conn->next_sequence);
+    }
+    conn->next_sequence = sequence + 1;
+    conn->sequence_valid = true;
+}
+
+// Full-scale settings the firmware can select; anything else would scale
+// the readings by a corrupt factor
+static bool valid_sensor_ranges(const SampleBlockHeader* block) {
+    bool accel = block->accel_range_g == 2 || block->accel_range_g == 4 ||
+                 block->accel_range_g == 8 || block->accel_range_g == 16;
+    bool gyro = block->gyro_range_dps == 250 || block->gyro_range_dps == 500 ||
+                block->gyro_range_dps == 1000 || block->gyro_range_dps == 2000;
+    return accel && gyro;
+}
+
+// Version 5: raw sensor LSBs, delta/varint coded. The whole frame is decoded
+// before anything is queued so a corrupt one is dropped as a unit.
+static void decode_delta_frame(BLEConnection* conn, const SensorFrameHeader* header,
+                               const uint8_t* data, size_t len, uint64_t arrival_ns) {
+    size_t prefix = sizeof(*header) + sizeof(ButtonEventHistory) + sizeof(DeltaFrameInfo);
+    DeltaFrameInfo info;
+    if (len >= prefix) memcpy(&info, data + sizeof(*header) + sizeof(ButtonEventHistory), sizeof(info));
+
+    CodecSample samples[SENSOR_FRAME_MAX_SAMPLES];
+    unsigned int count = 0;
+    bool valid = len >= prefix && header->count <= SENSOR_FRAME_MAX_SAMPLES &&
+                 info.block.encoding == SAMPLE_CODEC_DELTA_VARINT && valid_sensor_ranges(&info.block);
+    if (valid) {
+        SampleDecoder decoder;
+        sample_decoder_init(&decoder, data + prefix, len - prefix, header->timestamp);
+        while (count < header->count && sample_decoder_next(&decoder, &samples[count])) count++;
+        valid = count == header->count && sample_decoder_done(&decoder);
+    }
+    if (!valid) {
+        conn->queue.dropped++;
+        ASYNC_LOG(LOG_INFO, "Malformed sensor frame: %zu bytes, version %u, %u samples",
+               len, header->version, header->count);
+        return;
+    }
+
+    track_sequence(conn, header->sequence);
+
+    ButtonEventHistory history;
+    memcpy(&history, data + sizeof(*header), sizeof(history));
+
+    float accel_lsb = info.block.accel_range_g / 32768.0f;
+    float gyro_lsb = info.block.gyro_range_dps / 32768.0f;
+    for (unsigned int i = 0; i < count; i++) {
+        SensorSample* slot = packet_queue_reserve(&conn->queue);
+        if (!slot) {
+            conn->queue.dropped += count - i - 1;
+            return;
+        }
+
+        const CodecSample* sample = &samples[i];
+        memset(&slot->packet, 0, sizeof(slot->packet));
+        slot->packet.button_state = info.button_state;
+        slot->packet.button_sequence = info.button_sequence;
+        slot->packet.timestamp = (uint16_t)sample->timestamp_us;
+        for (int axis = 0; axis < 3; axis++) {
+            slot->accelerometer.array[axis] = sample->accel[axis] * accel_lsb;
+            slot->gyroscope.array[axis] = sample->gyro[axis] * gyro_lsb;
+        }
+        slot->device_time = sample->timestamp_us;
+        slot->tick_hz = 1000000;
+        slot->time_bits = 32;
+        slot->arrival_ns = arrival_ns;
+        slot->fused = false;
+        slot->has_button_history = true;
+        slot->button_history = history;
+        packet_queue_commit(&conn->queue);
+        conn->samples++;
+    }
+}
+
+// Bytes a version 1-4 frame with this header occupies, 0 for any other
+// version
+static size_t frame_length(const SensorFrameHeader* header) {
+    if (header->version < SENSOR_FRAME_VERSION_MS || header->version > SENSOR_FRAME_VERSION_FUSED) return 0;
+    size_t prefix = sizeof(*header) + (header->version >= SENSOR_FRAME_VERSION ? sizeof(ButtonEventHistory) : 0);
+    return prefix + header->count * sizeof(SensorPacket);
+}
+
+// Decode one notification payload, either a bare SensorPacket or a batched
+// frame, directly into queue slots in sample order
+static void decode_notification(BLEConnection* conn, const uint8_t* data, size_t len, uint64_t arrival_ns) {
+    conn->notifications++;
+    conn->payload_bytes += len;
+
+    SensorFrameHeader header;
+    bool has_header = len >= sizeof(header);
+    if (has_header) memcpy(&header, data, sizeof(header));
+
+    // An empty version 3 or 4 frame is as long as a bare packet, so the
+    // version byte decides: bare only when it does not announce a frame of
+    // exactly this length
+    if (len == sizeof(SensorPacket) && !(has_header && frame_length(&header) == len)) {
+        SensorSample* slot = packet_queue_reserve(&conn->queue);
+        if (!slot) return;
+
+        memcpy(&slot->packet, data, sizeof(SensorPacket));
+        unpack_readings(slot);
+        slot->device_time = slot->packet.timestamp;
+        slot->tick_hz = 1000;
+        slot->time_bits = 16;
+        slot->arrival_ns = arrival_ns;
+        slot->fused = false;
+        slot->has_button_history = false;
+        packet_queue_commit(&conn->queue);
+        conn->samples++;
+        return;
+    }
+
+    if (!has_header) {
+        conn->queue.dropped++;
+        ASYNC_LOG(LOG_INFO, "Received partial packet: %zu bytes (expected %zu)", len, sizeof(SensorPacket));
+        return;
+    }
+
+    if (header.version == SENSOR_FRAME_VERSION_DELTA) {
+        decode_delta_frame(conn, &header, data, len, arrival_ns);
+        return;
+    }
+
+    bool has_history = header.version >= SENSOR_FRAME_VERSION;
+    bool fused = header.version == SENSOR_FRAME_VERSION_FUSED;
+    size_t prefix = sizeof(header) + (has_history ? sizeof(ButtonEventHistory) : 0);
+    size_t expected = frame_length(&header);
+    if (expected == 0 || header.count > SENSOR_FRAME_MAX_SAMPLES || len != expected) {
+        conn->queue.dropped++;
+        ASYNC_LOG(LOG_INFO, "Malformed sensor frame: %zu bytes, version %u, %u samples",
+               len, header.version, header.count);
+        return;
+    }
+
+    track_sequence(conn, header.sequence);
+
+    ButtonEventHistory history;
+    if (has_history) memcpy(&history, data + sizeof(header), sizeof(history));
+
+    uint32_t tick_hz = header.version == SENSOR_FRAME_VERSION_MS ? 1000 : 1000000;
+    const uint8_t* p = data + prefix;
+    for (unsigned int i = 0; i < header.count; i++, p += sizeof(SensorPacket)) {
+        SensorSample* slot = packet_queue_reserve(&conn->queue);
+        if (!slot) {
+            conn->queue.dropped += header.count - i - 1;
+            return;
+        }
+
+        memcpy(&slot->packet, p, sizeof(SensorPacket));
+        if (fused) {
+            slot->accelerometer = FUSION_VECTOR_ZERO;
+            slot->gyroscope = FUSION_VECTOR_ZERO;
+        } else {
+            unpack_readings(slot);
+        }
+        // Extend the 16-bit sample timestamp with the header's full counter
+        slot->device_time = header.timestamp + (uint16_t)(slot->packet.timestamp - (uint16_t)header.timestamp);
+        slot->tick_hz = tick_hz;
+        slot->time_bits = 32;
+        slot->arrival_ns = arrival_ns;
+        slot->fused = fused;
+        slot->has_button_history = has_history;
+        if (has_history) slot->button_history = history;
+        packet_queue_commit(&conn->queue);
+        conn->samples++;
+    }
 }
 
 // Add notification handler
+static void deliver_samples(BLEConnection* conn) {
+    if (conn->on_samples && packet_queue_size(&conn->queue) > 0) {
+        conn->on_samples(conn, conn->on_samples_data);
+    }
+}
+
 static DBusHandlerResult notification_handler(DBusConnection* conn, DBusMessage* msg, void* user_data) {
     (void)conn;
     BLEConnection* ble_conn = (BLEConnection*)user_data;
@@ -336,26 +895,18 @@ static DBusHandlerResult notification_handler(DBusConnection* conn, DBusMessage*
                     dbus_message_iter_next(&entry_iter);
                     dbus_message_iter_recurse(&entry_iter, &variant_iter);
 
-                    if (dbus_message_iter_get_arg_type(&variant_iter) == DBUS_TYPE_ARRAY) {
+                    if (dbus_message_iter_get_arg_type(&variant_iter) == DBUS_TYPE_ARRAY &&
+                        dbus_message_iter_get_element_type(&variant_iter) == DBUS_TYPE_BYTE) {
                         dbus_message_iter_recurse(&variant_iter, &array_iter);
 
-                        uint8_t buffer[sizeof(SensorPacket)];
-                        int idx = 0;
-
-                        while (dbus_message_iter_get_arg_type(&array_iter) == DBUS_TYPE_BYTE &&
-                               idx < (int)sizeof(SensorPacket)) {
-                            dbus_message_iter_get_basic(&array_iter, &buffer[idx++]);
-                            dbus_message_iter_next(&array_iter);
-                        }
+                        // Decode straight from the message buffer, no per-byte walk
+                        const uint8_t* bytes = NULL;
+                        int len = 0;
+                        dbus_message_iter_get_fixed_array(&array_iter, &bytes, &len);
 
-                        if (idx == sizeof(SensorPacket)) {
-                            memcpy(&ble_conn->last_packet, buffer, sizeof(SensorPacket));
-                            ble_conn->packet_ready = true;
-                            // syslog(LOG_DEBUG, "Full packet received: %d bytes, packet_ready=%d",
-                            //        idx, ble_conn->packet_ready);
-                        } else if (idx > 0) {
-                            syslog(LOG_INFO, "Received partial packet: %d bytes (expected %zu)",
-                                   idx, sizeof(SensorPacket));
+                        if (len > 0) {
+                            decode_notification(ble_conn, bytes, len, monotonic_ns());
+                            deliver_samples(ble_conn);
                         }
                     }
                 }
@@ -368,27 +919,125 @@ static DBusHandlerResult notification_handler(DBusConnection* conn, DBusMessage*
     return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
 }
 
-int connect_to_device(BLEConnection* conn) {
-    if (!conn || !dbus_conn || strlen(conn->device_path) == 0) {
-        return -1;
+// Raw notifications from an AcquireNotify socket: one read per notification
+static void notify_fd_ready(int fd, uint32_t events, void* user_data) {
+    BLEConnection* conn = user_data;
+    uint8_t buffer[SENSOR_NOTIFY_MAX_LEN];
+
+    for (;;) {
+        // Hand samples over before a full frame might not fit; without a
+        // consumer the rest stays in the socket until the next wakeup
+        if (packet_queue_space(&conn->queue) < SENSOR_FRAME_MAX_SAMPLES) {
+            deliver_samples(conn);
+            if (packet_queue_space(&conn->queue) < SENSOR_FRAME_MAX_SAMPLES) break;
+        }
+
+        ssize_t len = read(fd, buffer, sizeof(buffer));
+        if (len > 0) {
+            decode_notification(conn, buffer, len, monotonic_ns());
+            continue;
+        }
+        if (len < 0 && (errno == EAGAIN || errno == EINTR)) break;
+
+        // EOF or error: BlueZ closed the socket, notifications have stopped
+        if (conn->connected) syslog(LOG_INFO, "Notification socket closed");
+        conn->connected = false;
+        break;
     }
 
-    syslog(LOG_INFO, "Connecting to device...");
+    deliver_samples(conn);
+
+    if ((events & (EPOLLHUP | EPOLLERR)) && !(events & EPOLLIN)) {
+        conn->connected = false;
+    }
+}
+
+// Ask BlueZ for a SEQPACKET socket carrying the characteristic's
+// notifications, bypassing PropertiesChanged signals. Returns 1 when the
+// method is not supported so the caller can fall back to StartNotify.
+static int acquire_notify(BLEConnection* conn) {
+    DBusMessage* msg = dbus_message_new_method_call(
+        BLUEZ_SERVICE, conn->char_path, "org.bluez.GattCharacteristic1", "AcquireNotify");
+    if (!msg) return -1;
+
+    DBusMessageIter iter, options;
+    dbus_message_iter_init_append(msg, &iter);
+    dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{sv}", &options);
+    dbus_message_iter_close_container(&iter, &options);
+
+    DBusError error;
+    dbus_error_init(&error);
+    DBusMessage* reply = dbus_connection_send_with_reply_and_block(dbus_conn, msg, 5000, &error);
+    dbus_message_unref(msg);
+
+    if (dbus_error_is_set(&error)) {
+        bool unsupported = dbus_error_has_name(&error, "org.bluez.Error.NotSupported") ||
+                           dbus_error_has_name(&error, DBUS_ERROR_UNKNOWN_METHOD);
+        syslog(unsupported ? LOG_INFO : LOG_ERR, "AcquireNotify failed: %s", error.message);
+        dbus_error_free(&error);
+        return unsupported ? 1 : -1;
+    }
+    if (!reply) return -1;
 
-    if (call_dbus_method(conn->device_path, "org.bluez.Device1", "Connect") != 0) {
+    int fd = -1;
+    dbus_uint16_t mtu = 0;
+    if (!dbus_message_get_args(reply, &error, DBUS_TYPE_UNIX_FD, &fd, DBUS_TYPE_UINT16, &mtu, DBUS_TYPE_INVALID)) {
+        syslog(LOG_ERR, "Bad AcquireNotify reply: %s", error.message);
+        dbus_error_free(&error);
+        dbus_message_unref(reply);
         return -1;
     }
+    dbus_message_unref(reply);
 
-    sleep(2);  // Connection establishment time
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    if (!event_loop || event_loop_add(event_loop, fd, EPOLLIN, notify_fd_ready, conn) < 0) {
+        close(fd);
+        return -1;
+    }
 
+    conn->notify_fd = fd;
+    syslog(LOG_INFO, "Notifications acquired on fd %d (MTU %u)", fd, mtu);
+    return 0;
+}
+
+// Fallback: notifications arrive as PropertiesChanged signals on the bus
+static int start_notify(BLEConnection* conn) {
+    DBusError error;
+    dbus_error_init(&error);
+    DBusMessage* notify_msg = dbus_message_new_method_call(
+        BLUEZ_SERVICE, conn->char_path, "org.bluez.GattCharacteristic1", "StartNotify");
+    if (notify_msg) {
+        DBusMessage* notify_reply = dbus_connection_send_with_reply_and_block(
+            dbus_conn, notify_msg, 5000, &error);
+        dbus_message_unref(notify_msg);
+        if (dbus_error_is_set(&error)) {
+            syslog(LOG_ERR, "Failed to enable notifications: %s", error.message);
+            dbus_error_free(&error);
+        } else if (notify_reply) {
+            dbus_message_unref(notify_reply);
+            syslog(LOG_INFO, "Notifications enabled successfully");
+        } else {
+            syslog(LOG_WARNING, "Failed to enable notifications (no reply)");
+        }
+    }
+
+    snprintf(conn->char_match, sizeof(conn->char_match),
+             "type='signal',interface='org.freedesktop.DBus.Properties',"
+             "member='PropertiesChanged',path='%s'", conn->char_path);
+    dbus_bus_add_match(dbus_conn, conn->char_match, NULL);
+    return 0;
+}
+
+// Walk the device's GATT objects for CHARACTERISTIC_UUID
+static bool find_characteristic(BLEConnection* conn) {
     // Discover services and characteristics
     DBusMessage* msg = dbus_message_new_method_call(
         BLUEZ_SERVICE, "/", "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
-    if (!msg) return -1;
+    if (!msg) return false;
 
     DBusMessage* reply = dbus_connection_send_with_reply_and_block(dbus_conn, msg, 10000, NULL);
     dbus_message_unref(msg);
-    if (!reply) return -1;
+    if (!reply) return false;
 
     DBusMessageIter iter, dict_iter, entry_iter, iface_dict_iter, iface_entry_iter;
     dbus_message_iter_init(reply, &iter);
@@ -454,88 +1103,382 @@ int connect_to_device(BLEConnection* conn) {
 
     dbus_message_unref(reply);
 
+    return found_char;
+}
+
+// Confirm a cached characteristic path still exists and carries our UUID
+static bool characteristic_matches(const char* char_path) {
+    DBusMessageIter variant;
+    DBusMessage* reply = get_property(char_path, "org.bluez.GattCharacteristic1", "UUID", &variant);
+    if (!reply) return false;
+
+    bool matches = false;
+    if (dbus_message_iter_get_arg_type(&variant) == DBUS_TYPE_STRING) {
+        char* uuid;
+        dbus_message_iter_get_basic(&variant, &uuid);
+        matches = strcasecmp(uuid, CHARACTERISTIC_UUID) == 0;
+    }
+    dbus_message_unref(reply);
+    return matches;
+}
+
+// Look up a boolean in a property dict (a{sv})
+static bool dict_bool(DBusMessageIter* props, const char* name, dbus_bool_t* value) {
+    DBusMessageIter dict_iter, entry_iter, variant_iter;
+
+    dbus_message_iter_recurse(props, &dict_iter);
+    while (dbus_message_iter_get_arg_type(&dict_iter) == DBUS_TYPE_DICT_ENTRY) {
+        dbus_message_iter_recurse(&dict_iter, &entry_iter);
+
+        char* prop_name;
+        dbus_message_iter_get_basic(&entry_iter, &prop_name);
+        if (strcmp(prop_name, name) == 0) {
+            dbus_message_iter_next(&entry_iter);
+            dbus_message_iter_recurse(&entry_iter, &variant_iter);
+            if (dbus_message_iter_get_arg_type(&variant_iter) != DBUS_TYPE_BOOLEAN) return false;
+            dbus_message_iter_get_basic(&variant_iter, value);
+            return true;
+        }
+
+        dbus_message_iter_next(&dict_iter);
+    }
+    return false;
+}
+
+// Once BlueZ has the GATT database: find the characteristic and enable
+// notifications. These calls go to BlueZ over a link that is already up.
+static int setup_connection(BLEConnection* conn) {
+    // A cached characteristic path skips the GetManagedObjects walk
+    if (conn->char_path[0] && !characteristic_matches(conn->char_path)) {
+        syslog(LOG_INFO, "Cached characteristic path is stale, rediscovering");
+        memset(conn->char_path, 0, sizeof(conn->char_path));
+    }
+    bool found_char = conn->char_path[0] || find_characteristic(conn);
+
     if (!found_char) {
         syslog(LOG_ERR, "Failed to find characteristic with UUID: %s", CHARACTERISTIC_UUID);
         call_dbus_method(conn->device_path, "org.bluez.Device1", "Disconnect");
         return -1;
     }
 
-    // Enable notifications
-    DBusError error;
-    dbus_error_init(&error);
-    DBusMessage* notify_msg = dbus_message_new_method_call(
-        BLUEZ_SERVICE, conn->char_path, "org.bluez.GattCharacteristic1", "StartNotify");
-    if (notify_msg) {
-        DBusMessage* notify_reply = dbus_connection_send_with_reply_and_block(
-            dbus_conn, notify_msg, 5000, &error);
-        dbus_message_unref(notify_msg);
-        if (dbus_error_is_set(&error)) {
-            syslog(LOG_ERR, "Failed to enable notifications: %s", error.message);
-            dbus_error_free(&error);
-        } else if (notify_reply) {
-            dbus_message_unref(notify_reply);
-            syslog(LOG_INFO, "Notifications enabled successfully");
-        } else {
-            syslog(LOG_WARNING, "Failed to enable notifications (no reply)");
-        }
+    conn->dbus_conn = dbus_conn;
+    packet_queue_init(&conn->queue);
+    conn->sequence_valid = false;
+    conn->frames_lost = 0;
+    conn->notifications = 0;
+    conn->payload_bytes = 0;
+    conn->samples = 0;
+
+    // Enable notifications, preferring the AcquireNotify socket
+    int acquired = config.acquire_notify ? acquire_notify(conn) : 1;
+    if (acquired < 0) {
+        call_dbus_method(conn->device_path, "org.bluez.Device1", "Disconnect");
+        return -1;
+    }
+    if (acquired > 0) {
+        start_notify(conn);
     }
-
-    // Add signal match rules for notifications and device state
-    char match_rule[512];
-    snprintf(match_rule, sizeof(match_rule),
-             "type='signal',interface='org.freedesktop.DBus.Properties',"
-             "member='PropertiesChanged',path='%s'", conn->char_path);
-    dbus_bus_add_match(dbus_conn, match_rule, NULL);
-
-    // Monitor device connection state
-    snprintf(match_rule, sizeof(match_rule),
-             "type='signal',interface='org.freedesktop.DBus.Properties',"
-             "member='PropertiesChanged',path='%s'", conn->device_path);
-    dbus_bus_add_match(dbus_conn, match_rule, NULL);
 
     // Register message handler
     dbus_connection_add_filter(dbus_conn, notification_handler, conn, NULL);
 
     conn->connected = true;
-    conn->dbus_conn = dbus_conn;
-    conn->packet_ready = false;
+    address_from_path(conn->device_path, conn->device_address, sizeof(conn->device_address));
+
+    // Remember where the device lives for the next reconnect
+    snprintf(conn->cached_device_path, sizeof(conn->cached_device_path), "%s", conn->device_path);
+    snprintf(conn->cached_char_path, sizeof(conn->cached_char_path), "%s", conn->char_path);
 
     syslog(LOG_INFO, "Connected successfully with characteristic path set");
     return 0;
 }
 
-int read_sensor_data(BLEConnection* conn, SensorPacket* packet) {
-    if (!conn || !packet || !conn->connected || !conn->dbus_conn) {
-        syslog(LOG_ERR, "read_sensor_data: invalid params");
+static DBusHandlerResult connect_handler(DBusConnection* bus, DBusMessage* msg, void* user_data);
+
+// Drops whatever a connection attempt is still waiting on
+static void disarm_connect(BLEConnection* conn) {
+    if (conn->pending_call) {
+        dbus_pending_call_cancel(conn->pending_call);
+        dbus_pending_call_unref(conn->pending_call);
+        conn->pending_call = NULL;
+    }
+    if (conn->resolve_timer_fd >= 0) {
+        event_loop_remove(event_loop, conn->resolve_timer_fd);
+        close(conn->resolve_timer_fd);
+        conn->resolve_timer_fd = -1;
+    }
+    if (conn->connect_phase != CONNECT_IDLE) dbus_connection_remove_filter(dbus_conn, connect_handler, conn);
+    conn->connect_phase = CONNECT_IDLE;
+}
+
+static void finish_connect(BLEConnection* conn, bool connected) {
+    disarm_connect(conn);
+    if (!connected && conn->device_match[0]) {
+        dbus_bus_remove_match(dbus_conn, conn->device_match, NULL);
+        memset(conn->device_match, 0, sizeof(conn->device_match));
+    }
+    if (conn->on_connect) conn->on_connect(conn, connected, conn->on_connect_data);
+}
+
+static void complete_connect(BLEConnection* conn) {
+    disarm_connect(conn);
+    finish_connect(conn, setup_connection(conn) == 0);
+}
+
+// BlueZ finishing GATT discovery for a connection being set up
+static DBusHandlerResult connect_handler(DBusConnection* bus, DBusMessage* msg, void* user_data) {
+    (void)bus;
+    BLEConnection* conn = user_data;
+    const char* path = dbus_message_get_path(msg);
+    if (!dbus_message_is_signal(msg, "org.freedesktop.DBus.Properties", "PropertiesChanged") || !path ||
+        strcmp(path, conn->device_path) != 0) {
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+    }
+
+    // (s interface, a{sv} changed, as invalidated)
+    DBusMessageIter iter;
+    char* interface = NULL;
+    if (dbus_message_iter_init(msg, &iter) && dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_STRING) {
+        dbus_message_iter_get_basic(&iter, &interface);
+    }
+    dbus_bool_t resolved = FALSE;
+    if (interface && strcmp(interface, "org.bluez.Device1") == 0 && dbus_message_iter_next(&iter) &&
+        dict_bool(&iter, "ServicesResolved", &resolved) && resolved) {
+        conn->services_resolved = true;
+        if (conn->connect_phase == CONNECT_RESOLVING) complete_connect(conn);
+    }
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
+static void resolve_timeout(int fd, uint32_t events, void* user_data) {
+    (void)fd;
+    (void)events;
+    syslog(LOG_WARNING, "Services not resolved after %d ms, continuing anyway", SERVICES_RESOLVE_TIMEOUT_MS);
+    complete_connect(user_data);
+}
+
+// ServicesResolved as it stood when Connect returned: a device BlueZ
+// already had resolved sends no PropertiesChanged for it
+static void resolved_reply(DBusPendingCall* call, void* user_data) {
+    BLEConnection* conn = user_data;
+    DBusMessage* reply = dbus_pending_call_steal_reply(call);
+    dbus_pending_call_unref(call);
+    conn->pending_call = NULL;
+
+    DBusMessageIter iter, variant;
+    if (reply && dbus_message_get_type(reply) == DBUS_MESSAGE_TYPE_METHOD_RETURN &&
+        dbus_message_iter_init(reply, &iter) && dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_VARIANT) {
+        dbus_message_iter_recurse(&iter, &variant);
+        dbus_bool_t resolved = FALSE;
+        if (dbus_message_iter_get_arg_type(&variant) == DBUS_TYPE_BOOLEAN) {
+            dbus_message_iter_get_basic(&variant, &resolved);
+        }
+        if (resolved) conn->services_resolved = true;
+    }
+    if (reply) dbus_message_unref(reply);
+
+    if (conn->services_resolved) complete_connect(conn);
+}
+
+static void connect_reply(DBusPendingCall* call, void* user_data) {
+    BLEConnection* conn = user_data;
+    DBusMessage* reply = dbus_pending_call_steal_reply(call);
+    dbus_pending_call_unref(call);
+    conn->pending_call = NULL;
+
+    DBusError error;
+    dbus_error_init(&error);
+    if (!reply || dbus_set_error_from_message(&error, reply)) {
+        syslog(LOG_ERR, "D-Bus error calling Connect: %s", dbus_error_is_set(&error) ? error.message : "no reply");
+        dbus_error_free(&error);
+        if (reply) dbus_message_unref(reply);
+        finish_connect(conn, false);
+        return;
+    }
+    dbus_message_unref(reply);
+
+    conn->connect_phase = CONNECT_RESOLVING;
+    if (conn->services_resolved) {
+        complete_connect(conn);
+        return;
+    }
+
+    conn->resolve_timer_fd = event_loop_add_timer(event_loop, SERVICES_RESOLVE_TIMEOUT_MS, resolve_timeout, conn);
+    if (conn->resolve_timer_fd < 0) {
+        complete_connect(conn);
+        return;
+    }
+    DBusMessage* msg = get_property_message(conn->device_path, "org.bluez.Device1", "ServicesResolved");
+    if (msg && dbus_connection_send_with_reply(dbus_conn, msg, &conn->pending_call, CONNECT_TIMEOUT_MS) &&
+        conn->pending_call) {
+        dbus_pending_call_set_notify(conn->pending_call, resolved_reply, conn, NULL);
+    }
+    if (msg) dbus_message_unref(msg);
+}
+
+// Start connecting without waiting for BlueZ: Connect can take seconds, or
+// until CONNECT_TIMEOUT_MS for a controller that is off or out of range,
+// and the loop keeps serving every other device meanwhile. The callback
+// runs once from the event loop or bluetooth_dispatch() with the outcome.
+int connect_device_async(BLEConnection* conn, ConnectCallback callback, void* user_data) {
+    if (!conn || !dbus_conn || !event_loop || !conn->device_path[0] || conn->connect_phase != CONNECT_IDLE) {
         return -1;
     }
 
-    if (strlen(conn->char_path) == 0) {
-        syslog(LOG_ERR, "Characteristic path not set");
+    DBusMessage* msg = dbus_message_new_method_call(BLUEZ_SERVICE, conn->device_path, "org.bluez.Device1", "Connect");
+    if (!msg) return -1;
+
+    syslog(LOG_INFO, "Connecting to device...");
+    conn->notify_fd = -1;
+    conn->resolve_timer_fd = -1;
+    conn->services_resolved = false;
+    conn->on_connect = callback;
+    conn->on_connect_data = user_data;
+
+    // Subscribe before Connect goes out so ServicesResolved cannot be missed;
+    // the rule stays to monitor the connection state afterwards
+    snprintf(conn->device_match, sizeof(conn->device_match),
+             "type='signal',interface='org.freedesktop.DBus.Properties',"
+             "member='PropertiesChanged',path='%s'", conn->device_path);
+    dbus_bus_add_match(dbus_conn, conn->device_match, NULL);
+    dbus_connection_add_filter(dbus_conn, connect_handler, conn, NULL);
+    conn->connect_phase = CONNECT_REQUESTED;
+
+    bool sent = dbus_connection_send_with_reply(dbus_conn, msg, &conn->pending_call, CONNECT_TIMEOUT_MS) &&
+                conn->pending_call;
+    dbus_message_unref(msg);
+    if (!sent) {
+        syslog(LOG_ERR, "Failed to send Connect");
+        conn->on_connect = NULL;
+        finish_connect(conn, false);
         return -1;
     }
+    dbus_pending_call_set_notify(conn->pending_call, connect_reply, conn, NULL);
+    return 0;
+}
 
-    // Use timeout of 0 to make it non-blocking and allow signal handling
-    dbus_connection_read_write_dispatch(conn->dbus_conn, 0);
+// Abandons a connection attempt in progress without reporting it
+void cancel_connect(BLEConnection* conn) {
+    if (!conn || conn->connect_phase == CONNECT_IDLE) return;
 
-    // Check if we have a new packet
-    if (conn->packet_ready) {
-        memcpy(packet, &conn->last_packet, sizeof(SensorPacket));
-        conn->packet_ready = false;
-        return 1;
+    conn->on_connect = NULL;
+    finish_connect(conn, false);
+    call_dbus_method(conn->device_path, "org.bluez.Device1", "Disconnect");
+}
+
+static void connect_done(BLEConnection* conn, bool connected, void* user_data) {
+    (void)conn;
+    *(int*)user_data = connected ? 1 : -1;
+}
+
+// Blocking form for one-off tools, servicing the event loop meanwhile
+int connect_to_device(BLEConnection* conn) {
+    int result = 0;
+    if (connect_device_async(conn, connect_done, &result) < 0) return -1;
+
+    while (running && result == 0) {
+        if (pump_events(-1) < 0) break;
     }
+    if (result == 0) cancel_connect(conn);
+    return result > 0 ? 0 : -1;
+}
+
+// Fast path after a dropout: Connect straight to the last known device and
+// characteristic paths, skipping discovery and the GATT object walk. Like
+// connect_device_async(), the outcome goes to the callback.
+int reconnect_cached_device(BLEConnection* conn, ConnectCallback callback, void* user_data) {
+    if (!conn || !dbus_conn || !conn->cached_device_path[0]) return -1;
+
+    // Cached paths from another adapter are useless
+    if (strstr(conn->cached_device_path, adapter_path) != conn->cached_device_path) return -1;
+
+    snprintf(conn->device_path, sizeof(conn->device_path), "%s", conn->cached_device_path);
+    snprintf(conn->char_path, sizeof(conn->char_path), "%s", conn->cached_char_path);
+    syslog(LOG_INFO, "Reconnecting to cached device %s", conn->device_path);
 
+    if (connect_device_async(conn, callback, user_data) < 0) {
+        memset(conn->device_path, 0, sizeof(conn->device_path));
+        memset(conn->char_path, 0, sizeof(conn->char_path));
+        return -1;
+    }
     return 0;
 }
 
+// On-disk copy of the cached paths so restarts reconnect directly too
+void load_device_cache(BLEConnection* conn, const char* file_path) {
+    FILE* file = fopen(file_path, "r");
+    if (!file) return;
+
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\n")] = '\0';
+        char* value = strchr(line, '=');
+        if (!value) continue;
+        *value++ = '\0';
+
+        if (strcmp(line, "device_path") == 0) {
+            snprintf(conn->cached_device_path, sizeof(conn->cached_device_path), "%s", value);
+        } else if (strcmp(line, "char_path") == 0) {
+            snprintf(conn->cached_char_path, sizeof(conn->cached_char_path), "%s", value);
+        } else if (strcmp(line, "name") == 0) {
+            snprintf(conn->device_name, sizeof(conn->device_name), "%s", value);
+        }
+    }
+    fclose(file);
+
+    if (conn->cached_device_path[0]) {
+        syslog(LOG_INFO, "Loaded cached device %s from %s", conn->cached_device_path, file_path);
+    }
+}
+
+void save_device_cache(const BLEConnection* conn, const char* file_path) {
+    FILE* file = fopen(file_path, "w");
+    if (!file) {
+        syslog(LOG_WARNING, "Cannot write device cache %s: %s", file_path, strerror(errno));
+        return;
+    }
+    fprintf(file, "device_path=%s\nchar_path=%s\nname=%s\n",
+            conn->cached_device_path, conn->cached_char_path, conn->device_name);
+    fclose(file);
+}
+
+// Consumer side of the packet queue, normally called from on_samples.
+// Samples decoded just before a disconnect can still be drained.
+int read_sensor_data(BLEConnection* conn, SensorSample* sample) {
+    if (!conn || !sample) {
+        syslog(LOG_ERR, "read_sensor_data: invalid params");
+        return -1;
+    }
+
+    return packet_queue_pop(&conn->queue, sample) ? 1 : 0;
+}
+
 void disconnect_device(BLEConnection* conn) {
     if (!conn || !conn->dbus_conn) return;
 
+    // StartNotify sessions outlive the filter; BlueZ ends them itself when
+    // the link drops
+    if (conn->connected && conn->notify_fd < 0 && conn->char_match[0]) {
+        call_dbus_method(conn->char_path, "org.bluez.GattCharacteristic1", "StopNotify");
+    }
     if (conn->connected && strlen(conn->device_path) > 0) {
         call_dbus_method(conn->device_path, "org.bluez.Device1", "Disconnect");
         syslog(LOG_INFO, "Disconnected from device");
     }
 
+    if (conn->notify_fd >= 0) {
+        if (event_loop) event_loop_remove(event_loop, conn->notify_fd);
+        close(conn->notify_fd);
+        conn->notify_fd = -1;
+    }
+    dbus_connection_remove_filter(conn->dbus_conn, notification_handler, conn);
+
+    // Without this every reconnect would leave two more rules on the bus
+    if (conn->char_match[0]) dbus_bus_remove_match(conn->dbus_conn, conn->char_match, NULL);
+    if (conn->device_match[0]) dbus_bus_remove_match(conn->dbus_conn, conn->device_match, NULL);
+    memset(conn->char_match, 0, sizeof(conn->char_match));
+    memset(conn->device_match, 0, sizeof(conn->device_match));
+
     conn->connected = false;
     memset(conn->device_path, 0, sizeof(conn->device_path));
     memset(conn->service_path, 0, sizeof(conn->service_path));
@@ -544,7 +1487,12 @@ void disconnect_device(BLEConnection* conn) {
 
 void cleanup_bluetooth() {
     if (dbus_conn) {
-        call_dbus_method(adapter_path, "org.bluez.Adapter1", "StopDiscovery");
+        stop_discovery();
+        if (event_loop) {
+            dbus_connection_set_watch_functions(dbus_conn, NULL, NULL, NULL, NULL, NULL);
+            dbus_connection_set_timeout_functions(dbus_conn, NULL, NULL, NULL, NULL, NULL);
+            event_loop = NULL;
+        }
         dbus_connection_unref(dbus_conn);
         dbus_conn = NULL;
     }
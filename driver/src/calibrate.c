@@ -0,0 +1,208 @@
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <syslog.h>
+#include <unistd.h>
+#include "calibration.h"
+#include "bluetooth.h"
+#include "common.h"
+#include "event_loop.h"
+#include "gyro_offset.h"
+#include "timing.h"
+
+#define CAPTURE_SAMPLES      400   // About 2 s per pose at 200 Hz
+#define CAPTURE_TIMEOUT_MS   10000
+#define STILL_GYRO_STDDEV    1.0f  // deg/s per axis
+#define STILL_ACCEL_STDDEV   0.03f // g per axis
+#define POSE_MIN_GRAVITY     0.7f  // g along the axis that should point up
+
+static const char* pose_names[CALIBRATION_POSES] = {
+    "+X (right edge) up", "-X (left edge) up",
+    "+Y (top edge) up",   "-Y (bottom edge) up",
+    "+Z (screen) up",     "-Z (screen) down"
+};
+
+// Running sums for one pose
+typedef struct {
+    bool active;
+    unsigned int count;
+    unsigned int fused;     // Samples without raw readings (on-device fusion firmware)
+    double accel_sum[3], accel_sq[3];
+    double gyro_sum[3], gyro_sq[3];
+} PoseCapture;
+
+static bool input_ready = false;
+
+static void stdin_ready(int fd, uint32_t events, void* user_data) {
+    (void)events;
+    (void)user_data;
+    char line[128];
+    if (read(fd, line, sizeof(line)) <= 0) running = false;
+    input_ready = true;
+}
+
+static void capture_samples(BLEConnection* conn, void* user_data) {
+    PoseCapture* capture = user_data;
+    SensorSample sample;
+
+    while (read_sensor_data(conn, &sample) == 1) {
+        if (!capture->active || capture->count >= CAPTURE_SAMPLES) continue;
+        if (sample.fused) {
+            capture->fused++;
+            continue;
+        }
+
+        for (int i = 0; i < 3; i++) {
+            double accel = sample.accelerometer.array[i];
+            double gyro = sample.gyroscope.array[i];
+            capture->accel_sum[i] += accel;
+            capture->accel_sq[i] += accel * accel;
+            capture->gyro_sum[i] += gyro;
+            capture->gyro_sq[i] += gyro * gyro;
+        }
+        capture->count++;
+    }
+}
+
+static float stddev(double sum, double sq, unsigned int count) {
+    double mean = sum / count;
+    double variance = sq / count - mean * mean;
+    return variance > 0.0 ? (float)sqrt(variance) : 0.0f;
+}
+
+// Waits for Enter while keeping the connection serviced
+static bool wait_for_enter(EventLoop* loop, BLEConnection* conn) {
+    input_ready = false;
+    while (running && conn->connected && !input_ready) {
+        if (event_loop_run_once(loop, 100) < 0) return false;
+        bluetooth_dispatch();
+    }
+    return running && conn->connected;
+}
+
+static int capture_pose(EventLoop* loop, BLEConnection* conn, PoseCapture* capture, int index,
+                        CalibrationPose* pose) {
+    for (;;) {
+        printf("Place the device still with %s, then press Enter\n", pose_names[index]);
+        fflush(stdout);
+        if (!wait_for_enter(loop, conn)) return -1;
+
+        memset(capture, 0, sizeof(*capture));
+        capture->active = true;
+        uint64_t deadline = monotonic_ns() + CAPTURE_TIMEOUT_MS * 1000000ULL;
+        while (running && conn->connected && capture->count < CAPTURE_SAMPLES && monotonic_ns() < deadline) {
+            if (event_loop_run_once(loop, 100) < 0) break;
+            bluetooth_dispatch();
+        }
+        capture->active = false;
+
+        if (!running || !conn->connected) return -1;
+        if (capture->fused > 0) {
+            printf("The firmware sends fused orientation, calibration needs a raw payload build\n");
+            return -1;
+        }
+        if (capture->count < CAPTURE_SAMPLES) {
+            printf("Only %u samples arrived, trying again\n", capture->count);
+            continue;
+        }
+
+        bool still = true;
+        for (int i = 0; i < 3; i++) {
+            pose->accelerometer.array[i] = (float)(capture->accel_sum[i] / capture->count);
+            pose->gyroscope.array[i] = (float)(capture->gyro_sum[i] / capture->count);
+            if (stddev(capture->gyro_sum[i], capture->gyro_sq[i], capture->count) > STILL_GYRO_STDDEV ||
+                stddev(capture->accel_sum[i], capture->accel_sq[i], capture->count) > STILL_ACCEL_STDDEV) {
+                still = false;
+            }
+        }
+        if (!still) {
+            printf("The device moved during capture, trying again\n");
+            continue;
+        }
+
+        int axis = index / 2;
+        float expected = index % 2 == 0 ? 1.0f : -1.0f;
+        if (pose->accelerometer.array[axis] * expected < POSE_MIN_GRAVITY) {
+            printf("Gravity reads %.2f g on %c, expected %+.0f g: check the orientation\n",
+                   pose->accelerometer.array[axis], "XYZ"[axis], expected);
+            continue;
+        }
+        return 0;
+    }
+}
+
+static int calibrate_device(EventLoop* loop, BLEConnection* conn, PoseCapture* capture) {
+    if (scan_for_device(conn) < 0 || connect_to_device(conn) < 0) {
+        syslog(LOG_ERR, "No M5 device to calibrate");
+        return -1;
+    }
+    printf("Calibrating %s (%s)\n", conn->device_name, conn->device_address);
+
+    CalibrationPose poses[CALIBRATION_POSES];
+    for (int i = 0; i < CALIBRATION_POSES; i++) {
+        if (capture_pose(loop, conn, capture, i, &poses[i]) < 0) {
+            syslog(LOG_ERR, "Calibration aborted");
+            return -1;
+        }
+    }
+
+    ImuCalibration cal;
+    char path[512];
+    if (calibration_solve(poses, &cal) < 0 || !calibration_path(conn->device_address, path, sizeof(path)) ||
+        imu_calibration_save(&cal, path) < 0) {
+        return -1;
+    }
+
+    const InertialCalibration* accel = &cal.accelerometer;
+    printf("Gyroscope offset: %.3f %.3f %.3f deg/s\n",
+           cal.gyroscope.offset.axis.x, cal.gyroscope.offset.axis.y, cal.gyroscope.offset.axis.z);
+    printf("Accelerometer offset: %.4f %.4f %.4f g, sensitivity: %.4f %.4f %.4f\n",
+           accel->offset.axis.x, accel->offset.axis.y, accel->offset.axis.z,
+           accel->sensitivity.axis.x, accel->sensitivity.axis.y, accel->sensitivity.axis.z);
+    printf("Saved to %s\n", path);
+
+    // The daemon's persisted run-time bias was learned against the previous
+    // calibration and would be subtracted on top of the new gyroscope offset
+    if (gyro_offset_path(conn->device_address, path, sizeof(path)) && unlink(path) == 0) {
+        printf("Removed the previous gyro offset %s\n", path);
+    }
+    return 0;
+}
+
+// Interactive six-pose capture for the first controller found. The result
+// is stored under state_dir for the controller's address and applied by
+// the daemon on every later connection of that controller.
+int run_calibration() {
+    if (!config.state_dir[0]) {
+        fprintf(stderr, "Calibration needs state_dir set in the configuration\n");
+        return 1;
+    }
+    if (init_bluetooth() < 0) {
+        syslog(LOG_ERR, "Failed to initialize Bluetooth");
+        return 1;
+    }
+
+    PoseCapture capture;
+    memset(&capture, 0, sizeof(capture));
+
+    static BLEConnection conn;
+    conn.notify_fd = -1;
+    conn.on_samples = capture_samples;
+    conn.on_samples_data = &capture;
+
+    EventLoop loop;
+    if (event_loop_init(&loop) < 0 || bluetooth_attach_event_loop(&loop) < 0 ||
+        event_loop_add(&loop, STDIN_FILENO, EPOLLIN, stdin_ready, NULL) < 0) {
+        syslog(LOG_ERR, "Failed to initialize event loop");
+        cleanup_bluetooth();
+        return 1;
+    }
+
+    int result = calibrate_device(&loop, &conn, &capture) == 0 ? 0 : 1;
+
+    if (conn.connected) disconnect_device(&conn);
+    cleanup_bluetooth();
+    event_loop_cleanup(&loop);
+    return result;
+}
@@ -0,0 +1,179 @@
+#define _GNU_SOURCE
+#include "calibration.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include "common.h"
+
+#define CALIBRATION_FILE "calibration"
+
+static void inertial_identity(InertialCalibration* cal) {
+    cal->misalignment = FUSION_IDENTITY_MATRIX;
+    cal->sensitivity = FUSION_VECTOR_ONES;
+    cal->offset = FUSION_VECTOR_ZERO;
+}
+
+void imu_calibration_identity(ImuCalibration* cal) {
+    inertial_identity(&cal->gyroscope);
+    inertial_identity(&cal->accelerometer);
+}
+
+// Precomputed once per connection so each sample costs one 3x3 multiply-add
+void calibration_fuse(const InertialCalibration* cal, FusedCalibration* fused) {
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            fused->matrix.array[row][col] = cal->misalignment.array[row][col] * cal->sensitivity.array[col];
+        }
+    }
+    fused->bias = FusionMatrixMultiplyVector(fused->matrix, cal->offset);
+}
+
+static bool invert_matrix(const FusionMatrix* m, FusionMatrix* out) {
+    const float (*a)[3] = m->array;
+    float det = a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1])
+              - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0])
+              + a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+    if (fabsf(det) < 1e-6f) return false;
+
+    float inv = 1.0f / det;
+    out->array[0][0] = (a[1][1] * a[2][2] - a[1][2] * a[2][1]) * inv;
+    out->array[0][1] = (a[0][2] * a[2][1] - a[0][1] * a[2][2]) * inv;
+    out->array[0][2] = (a[0][1] * a[1][2] - a[0][2] * a[1][1]) * inv;
+    out->array[1][0] = (a[1][2] * a[2][0] - a[1][0] * a[2][2]) * inv;
+    out->array[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) * inv;
+    out->array[1][2] = (a[0][2] * a[1][0] - a[0][0] * a[1][2]) * inv;
+    out->array[2][0] = (a[1][0] * a[2][1] - a[1][1] * a[2][0]) * inv;
+    out->array[2][1] = (a[0][1] * a[2][0] - a[0][0] * a[2][1]) * inv;
+    out->array[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) * inv;
+    return true;
+}
+
+// Six-position method. Opposite poses cancel the offset; half their
+// difference is what the sensor reads for 1 g along that axis, so those
+// columns give sensitivity (diagonal) and misalignment (cross-axis terms).
+// The gyroscope is only still during capture: its offset is the mean
+// reading, sensitivity and misalignment need a rate table and stay unity.
+int calibration_solve(const CalibrationPose poses[CALIBRATION_POSES], ImuCalibration* cal) {
+    imu_calibration_identity(cal);
+
+    FusionVector accel_sum = FUSION_VECTOR_ZERO;
+    FusionVector gyro_sum = FUSION_VECTOR_ZERO;
+    for (int i = 0; i < CALIBRATION_POSES; i++) {
+        accel_sum = FusionVectorAdd(accel_sum, poses[i].accelerometer);
+        gyro_sum = FusionVectorAdd(gyro_sum, poses[i].gyroscope);
+    }
+    cal->accelerometer.offset = FusionVectorMultiplyScalar(accel_sum, 1.0f / CALIBRATION_POSES);
+    cal->gyroscope.offset = FusionVectorMultiplyScalar(gyro_sum, 1.0f / CALIBRATION_POSES);
+
+    FusionMatrix response;
+    for (int axis = 0; axis < 3; axis++) {
+        FusionVector up = poses[axis * 2].accelerometer;
+        FusionVector down = poses[axis * 2 + 1].accelerometer;
+        for (int row = 0; row < 3; row++) {
+            response.array[row][axis] = (up.array[row] - down.array[row]) * 0.5f;
+        }
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+        if (response.array[axis][axis] < 0.5f) {
+            syslog(LOG_ERR, "Calibration: axis %c did not read gravity in its poses", "XYZ"[axis]);
+            return -1;
+        }
+        cal->accelerometer.sensitivity.array[axis] = 1.0f / response.array[axis][axis];
+    }
+
+    // Scale rows to unit diagonal, then undo the remaining cross-axis coupling
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            response.array[row][col] *= cal->accelerometer.sensitivity.array[row];
+        }
+    }
+    if (!invert_matrix(&response, &cal->accelerometer.misalignment)) {
+        syslog(LOG_ERR, "Calibration: accelerometer axes are degenerate");
+        return -1;
+    }
+    return 0;
+}
+
+// Calibration belongs to the sensor, so it is stored per Bluetooth address
+bool calibration_path(const char* address, char* path, size_t size) {
+    if (!config.state_dir[0] || !address[0]) return false;
+    snprintf(path, size, "%s/%s-%s", config.state_dir, CALIBRATION_FILE, address);
+    return true;
+}
+
+static bool parse_floats(const char* value, float* out, int count) {
+    char* end;
+    for (int i = 0; i < count; i++) {
+        out[i] = strtof(value, &end);
+        if (end == value) return false;
+        value = end;
+    }
+    return true;
+}
+
+static bool parse_inertial(InertialCalibration* cal, const char* field, const char* value) {
+    if (strcmp(field, "offset") == 0) return parse_floats(value, cal->offset.array, 3);
+    if (strcmp(field, "sensitivity") == 0) return parse_floats(value, cal->sensitivity.array, 3);
+    if (strcmp(field, "misalignment") == 0) return parse_floats(value, &cal->misalignment.array[0][0], 9);
+    return false;
+}
+
+int imu_calibration_load(ImuCalibration* cal, const char* file_path) {
+    FILE* file = fopen(file_path, "r");
+    if (!file) return -1;
+
+    imu_calibration_identity(cal);
+    int errors = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\n")] = '\0';
+        char* value = strchr(line, '=');
+        if (!value) continue;
+        *value++ = '\0';
+
+        bool parsed = false;
+        if (strncmp(line, "gyroscope.", 10) == 0) {
+            parsed = parse_inertial(&cal->gyroscope, line + 10, value);
+        } else if (strncmp(line, "accelerometer.", 14) == 0) {
+            parsed = parse_inertial(&cal->accelerometer, line + 14, value);
+        }
+        if (!parsed) {
+            syslog(LOG_WARNING, "Ignoring calibration entry '%s' in %s", line, file_path);
+            errors++;
+        }
+    }
+    fclose(file);
+
+    if (errors > 0) {
+        imu_calibration_identity(cal);
+        return -1;
+    }
+    return 0;
+}
+
+static void write_inertial(FILE* file, const char* name, const InertialCalibration* cal) {
+    const FusionMatrix* m = &cal->misalignment;
+    fprintf(file, "%s.offset=%.6f %.6f %.6f\n", name, cal->offset.axis.x, cal->offset.axis.y, cal->offset.axis.z);
+    fprintf(file, "%s.sensitivity=%.6f %.6f %.6f\n", name,
+            cal->sensitivity.axis.x, cal->sensitivity.axis.y, cal->sensitivity.axis.z);
+    fprintf(file, "%s.misalignment=%.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f\n", name,
+            m->element.xx, m->element.xy, m->element.xz,
+            m->element.yx, m->element.yy, m->element.yz,
+            m->element.zx, m->element.zy, m->element.zz);
+}
+
+int imu_calibration_save(const ImuCalibration* cal, const char* file_path) {
+    FILE* file = fopen(file_path, "w");
+    if (!file) {
+        syslog(LOG_ERR, "Cannot write calibration %s: %s", file_path, strerror(errno));
+        return -1;
+    }
+    write_inertial(file, "gyroscope", &cal->gyroscope);
+    write_inertial(file, "accelerometer", &cal->accelerometer);
+    fclose(file);
+    return 0;
+}
@@ -1,22 +1,143 @@
 #include "common.h"
+#include "axes_remap.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <syslog.h>
 #include <yaml.h>
 
-static void parse_yaml_value(const char* key, yaml_node_t* value_node) {
+DeviceConfig device_configs[MAX_DEVICES];
+int device_config_count = 0;
+
+static void parse_yaml_value(MouseConfig* cfg, const char* key, yaml_node_t* value_node) {
     if (value_node->type == YAML_SCALAR_NODE) {
         char* value = (char*)value_node->data.scalar.value;
 
-        if (strcmp(key, "movement_sensitivity") == 0) {
-            config.movement_sensitivity = atof(value);
+        if (strcmp(key, "pointer_mode") == 0) {
+            if (strcmp(value, "absolute") == 0) {
+                cfg->pointer_mode = POINTER_MODE_ABSOLUTE;
+            } else if (strcmp(value, "gyro") == 0) {
+                cfg->pointer_mode = POINTER_MODE_GYRO;
+            } else if (strcmp(value, "relative") == 0) {
+                cfg->pointer_mode = POINTER_MODE_RELATIVE;
+            } else {
+                syslog(LOG_WARNING, "Unknown pointer_mode '%s', keeping the previous mode", value);
+            }
+        } else if (strcmp(key, "mounting") == 0) {
+            if (!axes_alignment_parse(value, &cfg->mounting)) {
+                syslog(LOG_WARNING, "Unknown mounting '%s', expected e.g. +X+Y+Z or +Y-X+Z", value);
+            }
+        } else if (strcmp(key, "absolute_yaw_range") == 0) {
+            cfg->absolute_yaw_range = atof(value);
+        } else if (strcmp(key, "absolute_pitch_range") == 0) {
+            cfg->absolute_pitch_range = atof(value);
+        } else if (strcmp(key, "gyro_sensitivity") == 0) {
+            cfg->gyro_sensitivity = atof(value);
+        } else if (strcmp(key, "gyro_dead_zone") == 0) {
+            cfg->gyro_dead_zone = atof(value);
+        } else if (strcmp(key, "accel_profile") == 0) {
+            if (strcmp(value, "flat") == 0) {
+                cfg->accel_profile = ACCEL_PROFILE_FLAT;
+            } else if (strcmp(value, "linear") == 0) {
+                cfg->accel_profile = ACCEL_PROFILE_LINEAR;
+            } else if (strcmp(value, "power") == 0) {
+                cfg->accel_profile = ACCEL_PROFILE_POWER;
+            } else if (strcmp(value, "adaptive") == 0) {
+                cfg->accel_profile = ACCEL_PROFILE_ADAPTIVE;
+            } else {
+                syslog(LOG_WARNING, "Unknown accel_profile '%s', keeping the previous profile", value);
+            }
+        } else if (strcmp(key, "accel_threshold") == 0) {
+            cfg->accel_threshold = atof(value);
+        } else if (strcmp(key, "accel_max_gain") == 0) {
+            cfg->accel_max_gain = atof(value);
+        } else if (strcmp(key, "zupt_gyro_threshold") == 0) {
+            cfg->zupt_gyro_threshold = atof(value);
+        } else if (strcmp(key, "zupt_accel_stddev") == 0) {
+            cfg->zupt_accel_stddev = atof(value);
+        } else if (strcmp(key, "velocity_highpass") == 0) {
+            cfg->velocity_highpass = atof(value);
+        } else if (strcmp(key, "motion_filter") == 0) {
+            if (strcmp(value, "none") == 0) {
+                cfg->motion_filter = MOTION_FILTER_NONE;
+            } else if (strcmp(value, "one_euro") == 0) {
+                cfg->motion_filter = MOTION_FILTER_ONE_EURO;
+            } else if (strcmp(value, "kalman") == 0) {
+                cfg->motion_filter = MOTION_FILTER_KALMAN;
+            } else {
+                syslog(LOG_WARNING, "Unknown motion_filter '%s', keeping the previous filter", value);
+            }
+        } else if (strcmp(key, "filter_min_cutoff") == 0) {
+            cfg->filter_min_cutoff = atof(value);
+        } else if (strcmp(key, "filter_beta") == 0) {
+            cfg->filter_beta = atof(value);
+        } else if (strcmp(key, "filter_d_cutoff") == 0) {
+            cfg->filter_d_cutoff = atof(value);
+        } else if (strcmp(key, "filter_process_noise") == 0) {
+            cfg->filter_process_noise = atof(value);
+        } else if (strcmp(key, "filter_measurement_noise") == 0) {
+            cfg->filter_measurement_noise = atof(value);
+        } else if (strcmp(key, "accel_exponent") == 0) {
+            cfg->accel_exponent = atof(value);
+        } else if (strcmp(key, "movement_sensitivity") == 0) {
+            cfg->movement_sensitivity = atof(value);
         } else if (strcmp(key, "dead_zone") == 0) {
-            config.dead_zone = atof(value);
+            cfg->dead_zone = atof(value);
+        } else if (strcmp(key, "scroll_enabled") == 0) {
+            cfg->scroll_enabled = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
+        } else if (strcmp(key, "scroll_sensitivity") == 0) {
+            cfg->scroll_sensitivity = atof(value);
+        } else if (strcmp(key, "scroll_threshold") == 0) {
+            cfg->scroll_threshold = atof(value);
+        } else if (strcmp(key, "scroll_filter_samples") == 0) {
+            cfg->scroll_filter_samples = atoi(value);
         } else if (strcmp(key, "invert_x") == 0) {
-            config.invert_x = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
+            cfg->invert_x = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
         } else if (strcmp(key, "invert_y") == 0) {
-            config.invert_y = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
+            cfg->invert_y = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
+        } else if (strcmp(key, "invert_scroll") == 0) {
+            cfg->invert_scroll = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
+        } else if (strcmp(key, "acquire_notify") == 0) {
+            cfg->acquire_notify = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
+        } else if (strcmp(key, "state_dir") == 0) {
+            snprintf(cfg->state_dir, sizeof(cfg->state_dir), "%s", value);
+        } else if (strcmp(key, "max_devices") == 0) {
+            cfg->max_devices = atoi(value);
+        }
+    }
+}
+
+// One entry of the `devices:` list: match keys plus overrides of the
+// global settings, which must already be parsed
+static void parse_device_section(yaml_document_t* document, yaml_node_t* node) {
+    if (node->type != YAML_MAPPING_NODE) return;
+    if (device_config_count >= MAX_DEVICES) {
+        syslog(LOG_WARNING, "Ignoring device sections beyond %d", MAX_DEVICES);
+        return;
+    }
+
+    DeviceConfig* device = &device_configs[device_config_count++];
+    memset(device, 0, sizeof(*device));
+    device->config = config;
+
+    yaml_node_pair_t* pair;
+    for (pair = node->data.mapping.pairs.start; pair < node->data.mapping.pairs.top; pair++) {
+        yaml_node_t* key_node = yaml_document_get_node(document, pair->key);
+        yaml_node_t* value_node = yaml_document_get_node(document, pair->value);
+        if (key_node->type != YAML_SCALAR_NODE) continue;
+
+        char* key = (char*)key_node->data.scalar.value;
+        if (value_node->type == YAML_SCALAR_NODE && strcmp(key, "name") == 0) {
+            snprintf(device->name, sizeof(device->name), "%s", (char*)value_node->data.scalar.value);
+        } else if (value_node->type == YAML_SCALAR_NODE && strcmp(key, "address") == 0) {
+            snprintf(device->address, sizeof(device->address), "%s", (char*)value_node->data.scalar.value);
+        } else if (strcmp(key, "acquire_notify") == 0 || strcmp(key, "state_dir") == 0 ||
+                   strcmp(key, "max_devices") == 0) {
+            // The transport, state directory and device limit are shared by
+            // every controller; an override here would be silently ignored
+            syslog(LOG_WARNING, "Ignoring %s in a device section, it is a global setting", key);
+        } else {
+            parse_yaml_value(&device->config, key, value_node);
         }
     }
 }
@@ -47,6 +168,7 @@ void load_config(const char* config_file) {
     }
 
     yaml_node_t* root = yaml_document_get_root_node(&document);
+    yaml_node_t* devices = NULL;
     if (root && root->type == YAML_MAPPING_NODE) {
         yaml_node_pair_t* pair;
         for (pair = root->data.mapping.pairs.start;
@@ -57,11 +179,40 @@ void load_config(const char* config_file) {
 
             if (key_node->type == YAML_SCALAR_NODE) {
                 char* key = (char*)key_node->data.scalar.value;
-                parse_yaml_value(key, value_node);
+                if (strcmp(key, "devices") == 0) {
+                    devices = value_node;
+                } else {
+                    parse_yaml_value(&config, key, value_node);
+                }
             }
         }
     }
 
+    // Device sections inherit the global settings, wherever they appear in the file
+    device_config_count = 0;
+    if (devices && devices->type == YAML_SEQUENCE_NODE) {
+        yaml_node_item_t* item;
+        for (item = devices->data.sequence.items.start; item < devices->data.sequence.items.top; item++) {
+            parse_device_section(&document, yaml_document_get_node(&document, *item));
+        }
+    }
+
+    // The ranges divide the orientation in absolute mode; a zero cutoff or
+    // measurement noise would freeze the smoothing filters
+    if (config.absolute_yaw_range <= 0.0f) config.absolute_yaw_range = 60.0f;
+    if (config.absolute_pitch_range <= 0.0f) config.absolute_pitch_range = 40.0f;
+    if (config.filter_min_cutoff <= 0.0f) config.filter_min_cutoff = 1.0f;
+    if (config.filter_d_cutoff <= 0.0f) config.filter_d_cutoff = 1.0f;
+    if (config.filter_measurement_noise <= 0.0f) config.filter_measurement_noise = 25.0f;
+    for (int i = 0; i < device_config_count; i++) {
+        MouseConfig* device = &device_configs[i].config;
+        if (device->absolute_yaw_range <= 0.0f) device->absolute_yaw_range = config.absolute_yaw_range;
+        if (device->absolute_pitch_range <= 0.0f) device->absolute_pitch_range = config.absolute_pitch_range;
+        if (device->filter_min_cutoff <= 0.0f) device->filter_min_cutoff = config.filter_min_cutoff;
+        if (device->filter_d_cutoff <= 0.0f) device->filter_d_cutoff = config.filter_d_cutoff;
+        if (device->filter_measurement_noise <= 0.0f) device->filter_measurement_noise = config.filter_measurement_noise;
+    }
+
     yaml_document_delete(&document);
     yaml_parser_delete(&parser);
     fclose(file);
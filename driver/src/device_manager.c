@@ -0,0 +1,480 @@
+#define _GNU_SOURCE
+#include "device_manager.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <syslog.h>
+#include "async_log.h"
+
+#define DEVICE_CACHE_FILE "device-cache"
+#define UINPUT_DEVICE_NAME "M5 Matrix IMU Mouse"
+
+// Runs from the event loop whenever a connection has queued samples
+static void device_samples_ready(BLEConnection* conn, void* user_data) {
+    MouseDevice* device = user_data;
+    SensorSample sample;
+
+    while (read_sensor_data(conn, &sample) > 0) {
+        MotionReport report;
+        if (motion_pipeline_process(&device->pipeline, &sample, &report)) {
+            emit_motion_report(&device->uinput, &report);
+        }
+        latency_histogram_record(&device->latency, monotonic_ns() - sample.arrival_ns);
+
+        ASYNC_LOG(LOG_DEBUG, "[%d] Accel: %.2f,%.2f,%.2f Gyro: %.2f,%.2f,%.2f Btn: %d", device->index,
+                  sample.accelerometer.axis.x, sample.accelerometer.axis.y, sample.accelerometer.axis.z,
+                  sample.gyroscope.axis.x, sample.gyroscope.axis.y, sample.gyroscope.axis.z,
+                  sample.packet.button_state);
+    }
+}
+
+static bool has_criteria(const MouseDevice* device) {
+    return device->match_name[0] || device->match_address[0];
+}
+
+static bool criteria_match(const MouseDevice* device, const char* name, const char* address) {
+    if (device->match_address[0] && strcasecmp(device->match_address, address) != 0) return false;
+    if (device->match_name[0] && !strstr(name, device->match_name)) return false;
+    return true;
+}
+
+// A path belongs to a slot while it is connected or about to reconnect to it
+static bool path_claimed(const DeviceManager* manager, const char* path) {
+    for (int i = 0; i < manager->count; i++) {
+        const MouseDevice* device = &manager->devices[i];
+        if (strcmp(device->conn.device_path, path) == 0) return true;
+        if (device->state != DEVICE_SEARCHING && strcmp(device->conn.cached_device_path, path) == 0) return true;
+    }
+    return false;
+}
+
+// Hand a discovered controller to a searching slot: its previous owner
+// first, then a slot configured for it, then any unconfigured slot
+static MouseDevice* select_slot(DeviceManager* manager, const char* path, const char* name, const char* address) {
+    MouseDevice* fresh = NULL;
+    MouseDevice* reused = NULL;
+
+    for (int i = 0; i < manager->count; i++) {
+        MouseDevice* device = &manager->devices[i];
+        if (device->state != DEVICE_SEARCHING) continue;
+
+        if (strcmp(device->conn.cached_device_path, path) == 0) return device;
+        if (has_criteria(device)) {
+            if (criteria_match(device, name, address)) return device;
+        } else if (!device->conn.cached_device_path[0]) {
+            if (!fresh) fresh = device;
+        } else if (!reused) {
+            reused = device;
+        }
+    }
+    return fresh ? fresh : reused;
+}
+
+static void device_found(const char* path, const char* name, const char* address, void* user_data) {
+    DeviceManager* manager = user_data;
+    if (path_claimed(manager, path)) return;
+
+    MouseDevice* device = select_slot(manager, path, name, address);
+    if (!device) return;
+
+    snprintf(device->conn.device_path, sizeof(device->conn.device_path), "%s", path);
+    snprintf(device->conn.device_name, sizeof(device->conn.device_name), "%s", name[0] ? name : "M5 device");
+    memset(device->conn.char_path, 0, sizeof(device->conn.char_path));
+    device->state = DEVICE_PENDING;
+    syslog(LOG_INFO, "Device %d: found %s (%s)", device->index, device->conn.device_name, address);
+}
+
+static void init_slot(MouseDevice* device, int index) {
+    memset(device, 0, sizeof(*device));
+    device->index = index;
+    device->conn.notify_fd = -1;
+    device->conn.on_samples = device_samples_ready;
+    device->conn.on_samples_data = device;
+
+    if (index < device_config_count) {
+        const DeviceConfig* section = &device_configs[index];
+        device->config = section->config;
+        memcpy(device->match_name, section->name, sizeof(device->match_name));
+        memcpy(device->match_address, section->address, sizeof(device->match_address));
+    } else {
+        device->config = config;
+    }
+
+    // The first slot keeps the single-device cache file name
+    if (config.state_dir[0]) {
+        if (index == 0) {
+            snprintf(device->cache_file, sizeof(device->cache_file), "%s/%s", config.state_dir, DEVICE_CACHE_FILE);
+        } else {
+            snprintf(device->cache_file, sizeof(device->cache_file), "%s/%s.%d", config.state_dir, DEVICE_CACHE_FILE, index);
+        }
+    }
+}
+
+int device_manager_init(DeviceManager* manager) {
+    memset(manager, 0, sizeof(*manager));
+
+    manager->count = config.max_devices > device_config_count ? config.max_devices : device_config_count;
+    if (manager->count < 1) manager->count = 1;
+    if (manager->count > MAX_DEVICES) manager->count = MAX_DEVICES;
+
+    for (int i = 0; i < manager->count; i++) {
+        MouseDevice* device = &manager->devices[i];
+        init_slot(device, i);
+
+        char name[UINPUT_MAX_NAME_SIZE];
+        if (i == 0) {
+            snprintf(name, sizeof(name), "%s", UINPUT_DEVICE_NAME);
+        } else {
+            snprintf(name, sizeof(name), "%s %d", UINPUT_DEVICE_NAME, i + 1);
+        }
+        motion_pipeline_init(&device->pipeline, &device->config);
+        bool absolute = device->config.pointer_mode == POINTER_MODE_ABSOLUTE;
+        if (init_uinput_device(&device->uinput, name, absolute) < 0) {
+            syslog(LOG_ERR, "Failed to initialize uinput device %d", i);
+            manager->count = i;
+            device_manager_cleanup(manager);
+            return -1;
+        }
+
+        if (device->cache_file[0]) {
+            load_device_cache(&device->conn, device->cache_file);
+        }
+        device->state = device->conn.cached_device_path[0] ? DEVICE_PENDING : DEVICE_SEARCHING;
+    }
+
+    manager->cpu_window_start_ns = process_cpu_ns();
+    syslog(LOG_INFO, "Serving up to %d device%s", manager->count, manager->count == 1 ? "" : "s");
+    return 0;
+}
+
+// Runs once an attempt has finished, so the backoff counts from its end
+// rather than from when the Connect went out
+static void schedule_retry(MouseDevice* device) {
+    device->backoff_ms = device->backoff_ms ? device->backoff_ms * 2 : RECONNECT_BACKOFF_MIN_MS;
+    if (device->backoff_ms > RECONNECT_BACKOFF_MAX_MS) device->backoff_ms = RECONNECT_BACKOFF_MAX_MS;
+    device->next_attempt_ns = monotonic_ns() + device->backoff_ms * 1000000ULL;
+
+    // Keep trying the last known path for a while, then let discovery
+    // find the controller again in case it moved
+    if (!device->conn.cached_device_path[0] || device->fast_attempts >= RECONNECT_FAST_ATTEMPTS) {
+        device->fast_attempts = 0;
+        device->state = DEVICE_SEARCHING;
+    } else {
+        device->state = DEVICE_PENDING;
+    }
+}
+
+static void save_gyro_offset(MouseDevice* device) {
+    char path[512];
+    bool converged = device->pipeline.gyro_offset.converged;
+    if (!converged || !gyro_offset_path(device->offset_address, path, sizeof(path))) return;
+
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        syslog(LOG_WARNING, "Cannot write gyro offset %s: %s", path, strerror(errno));
+        return;
+    }
+    FusionVector offset = gyro_offset_get(&device->pipeline.gyro_offset);
+    fprintf(file, "x=%.6f\ny=%.6f\nz=%.6f\nconverged=%d\nmounting=%s\n",
+            offset.axis.x, offset.axis.y, offset.axis.z, converged, axes_alignment_name(device->config.mounting));
+    fclose(file);
+    device->offset_saved = true;
+}
+
+// Seeds the pipeline with the offset learned on this controller before, so
+// the pointer does not drift while FusionOffset waits for a still period.
+// The offset is kept in body axes, so one learned for another mounting is
+// ignored.
+static void load_gyro_offset(MouseDevice* device) {
+    const char* address = device->conn.device_address;
+    if (strcmp(address, device->offset_address) == 0) return;
+
+    // Another controller's estimate is worse than none
+    gyro_offset_init(&device->pipeline.gyro_offset);
+    snprintf(device->offset_address, sizeof(device->offset_address), "%s", address);
+    device->offset_saved = false;
+
+    char path[512];
+    if (!gyro_offset_path(address, path, sizeof(path))) return;
+    FILE* file = fopen(path, "r");
+    if (!file) return;
+
+    FusionVector offset = FUSION_VECTOR_ZERO;
+    int converged = 0;
+    int fields = 0;
+    bool same_mounting = false;
+    char line[128];
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\n")] = '\0';
+        char* value = strchr(line, '=');
+        if (!value) continue;
+        *value++ = '\0';
+
+        if (strcmp(line, "x") == 0) {
+            offset.axis.x = strtof(value, NULL);
+            fields++;
+        } else if (strcmp(line, "y") == 0) {
+            offset.axis.y = strtof(value, NULL);
+            fields++;
+        } else if (strcmp(line, "z") == 0) {
+            offset.axis.z = strtof(value, NULL);
+            fields++;
+        } else if (strcmp(line, "converged") == 0) {
+            converged = atoi(value);
+        } else if (strcmp(line, "mounting") == 0) {
+            FusionAxesAlignment mounting;
+            same_mounting = axes_alignment_parse(value, &mounting) && mounting == device->config.mounting;
+        }
+    }
+    fclose(file);
+
+    if (fields != 3) {
+        syslog(LOG_WARNING, "Ignoring incomplete gyro offset %s", path);
+        return;
+    }
+    if (!same_mounting) {
+        syslog(LOG_INFO, "Device %d: ignoring gyro offset %s learned for another mounting", device->index, path);
+        return;
+    }
+    gyro_offset_restore(&device->pipeline.gyro_offset, offset, converged != 0);
+    device->offset_saved = true;
+    syslog(LOG_INFO, "Device %d: restored gyro offset (%.3f, %.3f, %.3f) deg/s%s", device->index,
+           offset.axis.x, offset.axis.y, offset.axis.z, converged ? "" : ", not converged");
+}
+
+// Applied on every connection: the file may have been written by
+// --calibrate since the controller was last seen. The run-time gyro offset
+// is learned on top of the calibrated readings, so it starts over whenever
+// the gyroscope calibration changes.
+static void load_calibration(MouseDevice* device) {
+    ImuCalibration calibration;
+    char path[512];
+    bool loaded = calibration_path(device->conn.device_address, path, sizeof(path)) &&
+                  imu_calibration_load(&calibration, path) == 0;
+    if (!loaded) imu_calibration_identity(&calibration);
+
+    FusedCalibration previous = device->pipeline.gyroscope_calibration;
+    motion_pipeline_set_calibration(&device->pipeline, &calibration);
+    if (memcmp(&previous, &device->pipeline.gyroscope_calibration, sizeof(previous)) != 0) {
+        gyro_offset_init(&device->pipeline.gyro_offset);
+        device->offset_saved = false;
+    }
+    if (loaded) syslog(LOG_INFO, "Device %d: applied IMU calibration from %s", device->index, path);
+}
+
+static void connection_established(MouseDevice* device) {
+    device->state = DEVICE_CONNECTED;
+    device->backoff_ms = 0;
+    device->fast_attempts = 0;
+    latency_histogram_reset(&device->latency);
+    if (device->cache_file[0]) {
+        save_device_cache(&device->conn, device->cache_file);
+    }
+    load_calibration(device);
+    load_gyro_offset(device);
+    syslog(LOG_INFO, "Device %d: connected to %s", device->index, device->conn.device_name);
+}
+
+// Runs from the event loop once BlueZ has answered the Connect
+static void connect_finished(BLEConnection* conn, bool connected, void* user_data) {
+    MouseDevice* device = user_data;
+    if (!connected) {
+        syslog(LOG_WARNING, "Device %d: connection failed, retrying...", device->index);
+        memset(conn->device_path, 0, sizeof(conn->device_path));
+        memset(conn->char_path, 0, sizeof(conn->char_path));
+        schedule_retry(device);
+        return;
+    }
+    connection_established(device);
+}
+
+// A discovered path is tried first, else the cached one. Until the
+// callback the slot stays DEVICE_CONNECTING, which the retry timer skips,
+// so a Connect that takes until its timeout is never overlapped by the
+// next attempt.
+static void attempt_connect(MouseDevice* device) {
+    if (device->conn.connect_phase != CONNECT_IDLE) return;
+
+    int started;
+    if (device->conn.device_path[0]) {
+        started = connect_device_async(&device->conn, connect_finished, device);
+        if (started < 0) memset(device->conn.device_path, 0, sizeof(device->conn.device_path));
+    } else {
+        device->fast_attempts++;
+        started = reconnect_cached_device(&device->conn, connect_finished, device);
+    }
+
+    if (started < 0) {
+        schedule_retry(device);
+        return;
+    }
+    device->state = DEVICE_CONNECTING;
+}
+
+static void log_queue_stats(const MouseDevice* device) {
+    const BLEConnection* conn = &device->conn;
+    if (conn->queue.dropped > 0 || conn->frames_lost > 0) {
+        syslog(LOG_WARNING, "Device %d packet queue: %u overflows, %u packets dropped, %u frames lost in transport",
+               device->index, conn->queue.overflows, conn->queue.dropped, conn->frames_lost);
+    }
+}
+
+// Average notification bytes per sample, which shows the frame format and
+// batching the firmware settled on for this link
+static void log_transport_stats(const MouseDevice* device) {
+    const BLEConnection* conn = &device->conn;
+    if (conn->samples == 0) return;
+
+    syslog(LOG_INFO, "Device %d transport: %.1f bytes per sample, %.1f samples per notification",
+           device->index, (double)conn->payload_bytes / conn->samples,
+           (double)conn->samples / conn->notifications);
+}
+
+static void log_latency(const MouseDevice* device) {
+    char label[64];
+    snprintf(label, sizeof(label), "Device %d arrival-to-uinput", device->index);
+    latency_histogram_log(&device->latency, label);
+}
+
+static void log_uinput_stats(MouseDevice* device) {
+    char label[64];
+    snprintf(label, sizeof(label), "Device %d uinput", device->index);
+    uinput_log_stats(&device->uinput, label);
+}
+
+static void log_filter_stats(MouseDevice* device) {
+    char label[64];
+    snprintf(label, sizeof(label), "Device %d", device->index);
+    motion_filter_log_stats(&device->pipeline.filter, label);
+}
+
+// The AHRS restarts from scratch on the next connection; buttons held when
+// the link dropped are released. The gyro offset estimate survives.
+static void reset_pipeline(MouseDevice* device) {
+    MotionReport report;
+    motion_pipeline_reset(&device->pipeline, &report);
+    emit_motion_report(&device->uinput, &report);
+}
+
+static void handle_disconnect(MouseDevice* device) {
+    log_latency(device);
+    log_queue_stats(device);
+    log_uinput_stats(device);
+    log_filter_stats(device);
+    disconnect_device(&device->conn);
+    reset_pipeline(device);
+    save_gyro_offset(device);
+    syslog(LOG_INFO, "Device %d: disconnected, will retry...", device->index);
+
+    device->backoff_ms = 0;
+    device->fast_attempts = 0;
+    device->next_attempt_ns = 0;
+    device->state = device->conn.cached_device_path[0] ? DEVICE_PENDING : DEVICE_SEARCHING;
+}
+
+// Connection management, run between event loop iterations. Connect is
+// sent without waiting and finishes from the loop, so connected devices
+// are processed while others connect.
+void device_manager_poll(DeviceManager* manager) {
+    for (int i = 0; i < manager->count && running; i++) {
+        MouseDevice* device = &manager->devices[i];
+
+        if (device->state == DEVICE_CONNECTED && !device->conn.connected) {
+            handle_disconnect(device);
+        }
+        if (device->state != DEVICE_PENDING || monotonic_ns() < device->next_attempt_ns) continue;
+
+        // BlueZ connects more reliably with discovery off
+        if (manager->discovering) {
+            stop_discovery();
+            manager->discovering = false;
+        }
+        attempt_connect(device);
+    }
+
+    bool searching = false;
+    for (int i = 0; i < manager->count; i++) {
+        if (manager->devices[i].state == DEVICE_SEARCHING) searching = true;
+    }
+
+    if (searching && !manager->discovering && running) {
+        syslog(LOG_INFO, "Scanning for M5 devices...");
+        manager->discovering = start_discovery(device_found, manager) == 0;
+    } else if (!searching && manager->discovering) {
+        stop_discovery();
+        manager->discovering = false;
+    }
+}
+
+// Event loop timeout until the next due connection attempt, -1 for none
+int device_manager_timeout_ms(const DeviceManager* manager) {
+    uint64_t now = monotonic_ns();
+    int timeout = -1;
+
+    for (int i = 0; i < manager->count; i++) {
+        const MouseDevice* device = &manager->devices[i];
+        if (device->state != DEVICE_PENDING) continue;
+
+        int wait = device->next_attempt_ns > now ? (int)((device->next_attempt_ns - now) / 1000000ULL) + 1 : 0;
+        if (timeout < 0 || wait < timeout) timeout = wait;
+    }
+    return timeout;
+}
+
+// Periodic statistics: latency and drops per device, CPU cost across all
+void device_manager_report(DeviceManager* manager) {
+    uint32_t notifications = 0;
+    int socket_devices = 0;
+    int connected = 0;
+
+    for (int i = 0; i < manager->count; i++) {
+        MouseDevice* device = &manager->devices[i];
+        if (device->state != DEVICE_CONNECTED) continue;
+
+        log_latency(device);
+        latency_histogram_reset(&device->latency);
+        log_queue_stats(device);
+        log_transport_stats(device);
+        log_uinput_stats(device);
+        log_filter_stats(device);
+
+        // Persist as soon as the estimate is trustworthy; refinements are
+        // written on disconnect
+        if (!device->offset_saved) save_gyro_offset(device);
+
+        notifications += device->conn.notifications;
+        if (device->conn.notify_fd >= 0) socket_devices++;
+        connected++;
+    }
+
+    uint32_t packets = notifications - manager->cpu_window_notifications;
+    if (connected > 0 && notifications >= manager->cpu_window_notifications && packets > 0) {
+        double cpu_ms = (process_cpu_ns() - manager->cpu_window_start_ns) / 1e6;
+        syslog(LOG_INFO, "CPU per 1000 packets: %.2f ms over %u packets from %d device%s (%d on AcquireNotify)",
+               cpu_ms * 1000.0 / packets, packets, connected, connected == 1 ? "" : "s", socket_devices);
+    }
+    manager->cpu_window_start_ns = process_cpu_ns();
+    manager->cpu_window_notifications = notifications;
+}
+
+void device_manager_cleanup(DeviceManager* manager) {
+    if (manager->discovering) {
+        stop_discovery();
+        manager->discovering = false;
+    }
+
+    for (int i = 0; i < manager->count; i++) {
+        MouseDevice* device = &manager->devices[i];
+        if (device->state == DEVICE_CONNECTING) cancel_connect(&device->conn);
+        if (device->state == DEVICE_CONNECTED) {
+            log_latency(device);
+            log_queue_stats(device);
+            disconnect_device(&device->conn);
+            reset_pipeline(device);
+            save_gyro_offset(device);
+        }
+        cleanup_uinput_device(&device->uinput);
+    }
+}
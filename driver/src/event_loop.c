@@ -0,0 +1,140 @@
+#define _GNU_SOURCE
+#include "event_loop.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <syslog.h>
+#include <unistd.h>
+
+static EventSource* find_source(EventLoop* loop, int fd) {
+    for (int i = 0; i < EVENT_LOOP_MAX_SOURCES; i++) {
+        if (loop->sources[i].fd == fd) return &loop->sources[i];
+    }
+    return NULL;
+}
+
+int event_loop_init(EventLoop* loop) {
+    if (!loop) return -1;
+
+    for (int i = 0; i < EVENT_LOOP_MAX_SOURCES; i++) {
+        loop->sources[i].fd = -1;
+    }
+
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop->epoll_fd < 0) {
+        syslog(LOG_ERR, "epoll_create1 failed: %s", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+int event_loop_add(EventLoop* loop, int fd, uint32_t events, EventCallback callback, void* user_data) {
+    if (!loop || fd < 0 || !callback) return -1;
+
+    EventSource* source = find_source(loop, -1);
+    if (!source) {
+        syslog(LOG_ERR, "Event loop full, cannot watch fd %d", fd);
+        return -1;
+    }
+
+    struct epoll_event ev = {0};
+    ev.events = events;
+    ev.data.ptr = source;
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        syslog(LOG_ERR, "epoll_ctl(ADD, %d) failed: %s", fd, strerror(errno));
+        return -1;
+    }
+
+    source->fd = fd;
+    source->is_timer = false;
+    source->callback = callback;
+    source->user_data = user_data;
+    return 0;
+}
+
+int event_loop_modify(EventLoop* loop, int fd, uint32_t events) {
+    if (!loop || fd < 0) return -1;
+
+    EventSource* source = find_source(loop, fd);
+    if (!source) return -1;
+
+    struct epoll_event ev = {0};
+    ev.events = events;
+    ev.data.ptr = source;
+    return epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+void event_loop_remove(EventLoop* loop, int fd) {
+    if (!loop || fd < 0) return;
+
+    EventSource* source = find_source(loop, fd);
+    if (!source) return;
+
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    source->fd = -1;
+    source->callback = NULL;
+    source->user_data = NULL;
+}
+
+// Periodic timer on a timerfd; returns the fd so the caller can remove it
+int event_loop_add_timer(EventLoop* loop, unsigned int interval_ms, EventCallback callback, void* user_data) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        syslog(LOG_ERR, "timerfd_create failed: %s", strerror(errno));
+        return -1;
+    }
+
+    struct itimerspec spec = {0};
+    spec.it_interval.tv_sec = interval_ms / 1000;
+    spec.it_interval.tv_nsec = (long)(interval_ms % 1000) * 1000000L;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(fd, 0, &spec, NULL) < 0 || event_loop_add(loop, fd, EPOLLIN, callback, user_data) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    find_source(loop, fd)->is_timer = true;
+    return fd;
+}
+
+// Wait for and dispatch ready sources. Returns the number of sources
+// dispatched, 0 on timeout or signal interruption, -1 on error.
+int event_loop_run_once(EventLoop* loop, int timeout_ms) {
+    struct epoll_event events[EVENT_LOOP_MAX_SOURCES];
+
+    int n = epoll_wait(loop->epoll_fd, events, EVENT_LOOP_MAX_SOURCES, timeout_ms);
+    if (n < 0) {
+        if (errno == EINTR) return 0;
+        syslog(LOG_ERR, "epoll_wait failed: %s", strerror(errno));
+        return -1;
+    }
+
+    for (int i = 0; i < n; i++) {
+        EventSource* source = events[i].data.ptr;
+        // A callback earlier in this batch may have removed the source
+        if (source->fd < 0 || !source->callback) continue;
+
+        if (source->is_timer) {
+            uint64_t expirations;
+            if (read(source->fd, &expirations, sizeof(expirations)) < 0) continue;
+        }
+
+        source->callback(source->fd, events[i].events, source->user_data);
+    }
+
+    return n;
+}
+
+void event_loop_cleanup(EventLoop* loop) {
+    if (!loop || loop->epoll_fd < 0) return;
+
+    for (int i = 0; i < EVENT_LOOP_MAX_SOURCES; i++) {
+        if (loop->sources[i].fd >= 0 && loop->sources[i].is_timer) {
+            close(loop->sources[i].fd);
+        }
+        loop->sources[i].fd = -1;
+    }
+
+    close(loop->epoll_fd);
+    loop->epoll_fd = -1;
+}
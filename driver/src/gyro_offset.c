@@ -0,0 +1,73 @@
+#include "gyro_offset.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "async_log.h"
+#include "common.h"
+
+#define GYRO_OFFSET_FILE "gyro-offset"
+
+void gyro_offset_init(GyroOffset* gyro) {
+    memset(gyro, 0, sizeof(*gyro));
+    gyro->sample_rate = GYRO_OFFSET_NOMINAL_RATE;
+    FusionOffsetInitialise(&gyro->offset, gyro->sample_rate);
+}
+
+// FusionOffset's filter coefficient and stationary timeout are per sample,
+// so they follow the measured packet rate; the estimate itself is kept
+static void measure_rate(GyroOffset* gyro, float dt) {
+    gyro->window_s += dt;
+    gyro->window_samples++;
+    if (gyro->window_s < GYRO_OFFSET_RATE_WINDOW_S) return;
+
+    unsigned int rate = (unsigned int)lrintf(gyro->window_samples / gyro->window_s);
+    gyro->window_s = 0.0f;
+    gyro->window_samples = 0;
+
+    if (rate == 0 || fabsf((float)rate - gyro->sample_rate) <= GYRO_OFFSET_RATE_TOLERANCE * gyro->sample_rate) return;
+
+    FusionVector estimate = gyro->offset.gyroscopeOffset;
+    FusionOffsetInitialise(&gyro->offset, rate);
+    gyro->offset.gyroscopeOffset = estimate;
+    ASYNC_LOG(LOG_INFO, "Gyro offset tracking at %u Hz (was %u Hz)", rate, gyro->sample_rate);
+    gyro->sample_rate = rate;
+}
+
+// Returns the bias-corrected gyroscope reading
+FusionVector gyro_offset_update(GyroOffset* gyro, FusionVector gyroscope, float dt) {
+    measure_rate(gyro, dt);
+
+    FusionVector before = gyro->offset.gyroscopeOffset;
+    FusionVector corrected = FusionOffsetUpdate(&gyro->offset, gyroscope);
+
+    // The estimate only moves once the device has been still for the timeout
+    if (memcmp(&before, &gyro->offset.gyroscopeOffset, sizeof(before)) != 0) {
+        gyro->adjusted_s += dt;
+        if (!gyro->converged && gyro->adjusted_s >= GYRO_OFFSET_CONVERGED_S) {
+            gyro->converged = true;
+            FusionVector estimate = gyro->offset.gyroscopeOffset;
+            ASYNC_LOG(LOG_INFO, "Gyro offset converged: (%.3f, %.3f, %.3f) deg/s",
+                      estimate.axis.x, estimate.axis.y, estimate.axis.z);
+        }
+    }
+    return corrected;
+}
+
+FusionVector gyro_offset_get(const GyroOffset* gyro) {
+    return gyro->offset.gyroscopeOffset;
+}
+
+// Seed the estimate, e.g. from a previous session with the same controller
+void gyro_offset_restore(GyroOffset* gyro, FusionVector offset, bool converged) {
+    gyro->offset.gyroscopeOffset = offset;
+    gyro->converged = converged;
+    gyro->adjusted_s = converged ? GYRO_OFFSET_CONVERGED_S : 0.0f;
+}
+
+// The gyro bias is a property of the sensor, so it is stored per Bluetooth
+// address rather than per slot
+bool gyro_offset_path(const char* address, char* path, size_t size) {
+    if (!config.state_dir[0] || !address[0]) return false;
+    snprintf(path, size, "%s/%s-%s", config.state_dir, GYRO_OFFSET_FILE, address);
+    return true;
+}
@@ -8,18 +8,48 @@
 #include <syslog.h>
 #include <sys/stat.h>
 #include "common.h"
+#include "async_log.h"
 #include "bluetooth.h"
-#include "uinput.h"
+#include "calibration.h"
+#include "device_manager.h"
+#include "event_loop.h"
+#include "timing.h"
+
+#define HOUSEKEEPING_INTERVAL_MS 1000
+#define LATENCY_REPORT_TICKS     10  // Housekeeping ticks between latency reports
 
 MouseConfig config = {
+    .pointer_mode = POINTER_MODE_RELATIVE,
+    .mounting = FusionAxesAlignmentPXPYPZ,
+    .absolute_yaw_range = 60.0f,        // Degrees of yaw across the screen in absolute mode
+    .absolute_pitch_range = 40.0f,
+    .gyro_sensitivity = 1.0f,           // Pixels per degree of rotation in gyro mode
+    .gyro_dead_zone = 1.5f,             // deg/s
+    .accel_profile = ACCEL_PROFILE_ADAPTIVE,
+    .accel_threshold = 60.0f,           // deg/s
+    .accel_max_gain = 4.0f,
+    .accel_exponent = 1.5f,
+    .motion_filter = MOTION_FILTER_NONE,
+    .filter_min_cutoff = 1.0f,          // Hz
+    .filter_beta = 0.02f,
+    .filter_d_cutoff = 1.0f,            // Hz
+    .filter_process_noise = 5000.0f,
+    .filter_measurement_noise = 25.0f,
+    .zupt_gyro_threshold = 3.0f,        // deg/s
+    .zupt_accel_stddev = 0.02f,         // g
+    .velocity_highpass = 0.5f,          // s
     .movement_sensitivity = 2.0f,       // Default: pixels per degree/second
+    .scroll_enabled = false,            // Tilt moves the cursor unless scrolling is asked for
     .scroll_sensitivity = 1.0f,
     .dead_zone = 0.05f,                 // Default: degrees/second threshold for angular velocity  
     .scroll_threshold = 0.3f,
     .invert_x = false,
     .invert_y = false,
     .invert_scroll = false,
-    .scroll_filter_samples = 5
+    .scroll_filter_samples = 5,
+    .acquire_notify = true,
+    .state_dir = "/var/lib/m5-mouse",
+    .max_devices = 1
 };
 
 bool running = true;
@@ -35,11 +65,24 @@ void signal_handler(int sig) {
     alarm(2);
 }
 
+// Periodic work driven by the event loop's timerfd
+static void housekeeping(int fd, uint32_t events, void* user_data) {
+    (void)fd;
+    (void)events;
+    DeviceManager* manager = user_data;
+
+    static unsigned int ticks = 0;
+    if (++ticks % LATENCY_REPORT_TICKS == 0) {
+        device_manager_report(manager);
+    }
+}
+
 void print_usage(const char* program_name) {
     printf("Usage: %s [OPTIONS]\n", program_name);
     printf("Options:\n");
     printf("  -c, --config FILE    Configuration file path\n");
     printf("  -d, --daemon         Run as daemon\n");
+    printf("      --calibrate      Capture an IMU calibration for the first device found\n");
     printf("  -v, --verbose        Verbose output\n");
     printf("  -h, --help           Show this help\n");
 }
@@ -47,11 +90,13 @@ void print_usage(const char* program_name) {
 int main(int argc, char* argv[]) {
     bool daemon_mode = false;
     bool verbose = false;
+    bool calibrate = false;
     char* config_file = "/etc/m5-mouse.yaml";
 
     static struct option long_options[] = {
         {"config", required_argument, 0, 'c'},
         {"daemon", no_argument, 0, 'd'},
+        {"calibrate", no_argument, 0, 'C'},
         {"verbose", no_argument, 0, 'v'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
@@ -66,6 +111,9 @@ int main(int argc, char* argv[]) {
             case 'd':
                 daemon_mode = true;
                 break;
+            case 'C':
+                calibrate = true;
+                break;
             case 'v':
                 verbose = true;
                 break;
@@ -86,6 +134,14 @@ int main(int argc, char* argv[]) {
     signal(SIGTERM, signal_handler);
     signal(SIGALRM, signal_handler);
 
+    // Interactive, so never daemonized
+    if (calibrate) {
+        openlog("m5-mouse-daemon", LOG_PID | LOG_PERROR, LOG_USER);
+        int result = run_calibration();
+        closelog();
+        return result;
+    }
+
     if (daemon_mode) {
         // Daemonize
         pid_t pid = fork();
@@ -110,78 +166,58 @@ int main(int argc, char* argv[]) {
         openlog("m5-mouse-daemon", LOG_PID | LOG_PERROR, LOG_USER);
     }
 
+    // Input-path logging goes through a ring drained by a writer thread;
+    // -v enables the per-packet debug records in a LOG_DEBUG build
+    async_log_start(verbose ? LOG_DEBUG : LOG_INFO);
+
     syslog(LOG_INFO, "M5 Mouse Daemon starting...");
 
     // Initialize Bluetooth
     if (init_bluetooth() < 0) {
         syslog(LOG_ERR, "Failed to initialize Bluetooth");
+        async_log_stop();
         return 1;
     }
 
-    // Initialize uinput device
-    UInputDevice uinput_device;
-    if (init_uinput_device(&uinput_device) < 0) {
-        syslog(LOG_ERR, "Failed to initialize uinput device");
+    // Every controller gets its own connection, AHRS state and uinput node
+    static DeviceManager manager;
+    if (device_manager_init(&manager) < 0) {
+        syslog(LOG_ERR, "Failed to initialize uinput devices");
         cleanup_bluetooth();
+        async_log_stop();
         return 1;
     }
 
-    syslog(LOG_INFO, "Scanning for M5 device...");
-
-    BLEConnection connection = {0};
+    // Single epoll reactor for the D-Bus socket, notification sockets and
+    // housekeeping timer, shared by all devices
+    EventLoop loop;
+    if (event_loop_init(&loop) < 0 || bluetooth_attach_event_loop(&loop) < 0 ||
+        event_loop_add_timer(&loop, HOUSEKEEPING_INTERVAL_MS, housekeeping, &manager) < 0) {
+        syslog(LOG_ERR, "Failed to initialize event loop");
+        device_manager_cleanup(&manager);
+        cleanup_bluetooth();
+        async_log_stop();
+        return 1;
+    }
 
+    // Sensor data is processed from the event loop callbacks; between
+    // iterations the manager starts due connection attempts and discovery.
+    // Messages libdbus already read off the socket (during a blocking call,
+    // or with the loop's last read) never wake epoll again, so they are
+    // dispatched before sleeping, and the manager gets another look at
+    // the state they changed before the loop may block.
     while (running) {
-        // Scan for device
-        if (scan_for_device(&connection) < 0) {
-            syslog(LOG_WARNING, "Device scan failed, retrying in 5 seconds...");
-            sleep(5);
-            continue;
-        }
-
-        syslog(LOG_INFO, "Found M5 device: %s", connection.device_name);
-
-        // Connect to device
-        if (connect_to_device(&connection) < 0) {
-            syslog(LOG_WARNING, "Connection failed, retrying in 5 seconds...");
-            sleep(5);
-            continue;
-        }
-
-        syslog(LOG_INFO, "Connected to M5 device");
-
-        // Main data processing loop
-        while (running && connection.connected) {
-            SensorPacket packet;
-            int result = read_sensor_data(&connection, &packet);
-
-            if (result < 0) {
-                syslog(LOG_WARNING, "Lost connection to device");
-                break;
-            }
-
-            if (result > 0) {
-                process_sensor_data(&uinput_device, &packet);
-
-                if (verbose && !daemon_mode) {
-                    printf("Accel: %.2f,%.2f,%.2f Gyro: %.2f,%.2f,%.2f Btn: %d\n",
-                           packet.accel_x / 100.0f, packet.accel_y / 100.0f, packet.accel_z / 100.0f,
-                           packet.gyro_x / 10.0f, packet.gyro_y / 10.0f, packet.gyro_z / 10.0f,
-                           packet.button_state);
-                }
-            }
-
-            usleep(20000); // 50Hz
-        }
-
-        disconnect_device(&connection);
-        syslog(LOG_INFO, "Disconnected from device, will retry...");
-        sleep(2);
+        device_manager_poll(&manager);
+        int timeout = bluetooth_dispatch() ? 0 : device_manager_timeout_ms(&manager);
+        if (event_loop_run_once(&loop, timeout) < 0) break;
     }
 
-    cleanup_uinput_device(&uinput_device);
+    device_manager_cleanup(&manager);
     cleanup_bluetooth();
+    event_loop_cleanup(&loop);
 
     syslog(LOG_INFO, "M5 Mouse Daemon stopped");
+    async_log_stop();
     closelog();
 
     return 0;
@@ -0,0 +1,157 @@
+#define _GNU_SOURCE
+#include "motion_filter.h"
+#include <math.h>
+#include <string.h>
+#include <syslog.h>
+
+static float bypass_step(MotionFilter* filter, int axis, float value, float dt) {
+    (void)filter;
+    (void)axis;
+    (void)dt;
+    return value;
+}
+
+static float smoothing_factor(float cutoff, float dt) {
+    float r = 2.0f * (float)M_PI * cutoff * dt;
+    return r / (r + 1.0f);
+}
+
+// One-Euro filter (Casiez et al.): a low-pass whose cutoff rises with the
+// speed of change, so slow motion is smoothed hard and fast motion lags little
+static float one_euro_step(MotionFilter* filter, int axis, float value, float dt) {
+    const MouseConfig* cfg = filter->config;
+    OneEuroAxis* state = &filter->axis.one_euro[axis];
+
+    if (!state->initialized) {
+        state->x_prev = value;
+        state->dx_prev = 0.0f;
+        state->initialized = true;
+        return value;
+    }
+
+    float dx = (value - state->x_prev) / dt;
+    state->dx_prev += smoothing_factor(cfg->filter_d_cutoff, dt) * (dx - state->dx_prev);
+
+    float cutoff = cfg->filter_min_cutoff + cfg->filter_beta * fabsf(state->dx_prev);
+    state->x_prev += smoothing_factor(cutoff, dt) * (value - state->x_prev);
+    return state->x_prev;
+}
+
+// Constant-velocity Kalman filter: the signal is modelled as drifting at a
+// velocity driven by white noise (filter_process_noise), observed with
+// filter_measurement_noise
+static float kalman_step(MotionFilter* filter, int axis, float value, float dt) {
+    const MouseConfig* cfg = filter->config;
+    KalmanAxis* k = &filter->axis.kalman[axis];
+
+    if (!k->initialized) {
+        memset(k, 0, sizeof(*k));
+        k->x = value;
+        k->p00 = cfg->filter_measurement_noise;
+        k->p11 = cfg->filter_measurement_noise;
+        k->initialized = true;
+        return value;
+    }
+
+    // Predict
+    float q = cfg->filter_process_noise;
+    float dt2 = dt * dt;
+    k->x += k->v * dt;
+    k->p00 += dt * (2.0f * k->p01 + dt * k->p11) + q * dt2 * dt2 * 0.25f;
+    k->p01 += dt * k->p11 + q * dt2 * dt * 0.5f;
+    k->p11 += q * dt2;
+
+    // Update with the measurement
+    float s = k->p00 + cfg->filter_measurement_noise;
+    float k0 = k->p00 / s;
+    float k1 = k->p01 / s;
+    float innovation = value - k->x;
+    k->x += k0 * innovation;
+    k->v += k1 * innovation;
+    k->p11 -= k1 * k->p01;
+    k->p01 -= k0 * k->p01;
+    k->p00 -= k0 * k->p00;
+    return k->x;
+}
+
+void motion_filter_init(MotionFilter* filter, const MouseConfig* cfg) {
+    memset(filter, 0, sizeof(*filter));
+    filter->config = cfg;
+    filter->type = cfg->motion_filter;
+
+    switch (filter->type) {
+        case MOTION_FILTER_ONE_EURO:
+            filter->step = one_euro_step;
+            break;
+        case MOTION_FILTER_KALMAN:
+            filter->step = kalman_step;
+            break;
+        case MOTION_FILTER_NONE:
+        default:
+            filter->step = bypass_step;
+            break;
+    }
+}
+
+static void record_stats(MotionFilterStats* stats, int axis, float in, float out, float dt) {
+    float* in_prev = stats->in_prev[axis];
+    float* out_prev = stats->out_prev[axis];
+
+    if (stats->samples >= 2) {
+        float jitter_in = in - 2.0f * in_prev[0] + in_prev[1];
+        float jitter_out = out - 2.0f * out_prev[0] + out_prev[1];
+        stats->jitter_in += jitter_in * jitter_in;
+        stats->jitter_out += jitter_out * jitter_out;
+        stats->error_sum += fabsf(out - in);
+        stats->slope_sum += fabsf(in - in_prev[0]) / dt;
+    }
+    in_prev[1] = in_prev[0];
+    in_prev[0] = in;
+    out_prev[1] = out_prev[0];
+    out_prev[0] = out;
+}
+
+void motion_filter_apply(MotionFilter* filter, float* x, float* y, float dt) {
+    if (filter->type == MOTION_FILTER_NONE) return;
+
+    float fx = filter->step(filter, 0, *x, dt);
+    float fy = filter->step(filter, 1, *y, dt);
+
+    record_stats(&filter->stats, 0, *x, fx, dt);
+    record_stats(&filter->stats, 1, *y, fy, dt);
+    filter->stats.samples++;
+
+    *x = fx;
+    *y = fy;
+}
+
+// Jitter reduction (fraction of the input's RMS second difference removed)
+// and added latency since the statistics were last cleared. False until
+// there is enough signal to tell.
+bool motion_filter_measure(const MotionFilter* filter, double* jitter_reduction, double* latency_ms) {
+    const MotionFilterStats* stats = &filter->stats;
+    if (filter->type == MOTION_FILTER_NONE || stats->samples < 3 || stats->jitter_in <= 0.0) return false;
+
+    *jitter_reduction = 1.0 - sqrt(stats->jitter_out / stats->jitter_in);
+    *latency_ms = stats->slope_sum > 0.0 ? stats->error_sum / stats->slope_sum * 1000.0 : 0.0;
+    return true;
+}
+
+void motion_filter_log_stats(MotionFilter* filter, const char* label) {
+    MotionFilterStats* stats = &filter->stats;
+    double jitter_reduction, latency_ms;
+    if (!motion_filter_measure(filter, &jitter_reduction, &latency_ms)) return;
+
+    syslog(LOG_INFO, "%s %s filter over %u samples: jitter reduced %.1f%%, added latency %.1f ms",
+           label, motion_filter_name(filter->type), stats->samples, jitter_reduction * 100.0, latency_ms);
+
+    memset(stats, 0, sizeof(*stats));
+}
+
+const char* motion_filter_name(MotionFilterType type) {
+    switch (type) {
+        case MOTION_FILTER_ONE_EURO: return "one_euro";
+        case MOTION_FILTER_KALMAN: return "kalman";
+        default: return "none";
+    }
+}
@@ -0,0 +1,519 @@
+#define _GNU_SOURCE
+#include "pipeline.h"
+#include <math.h>
+#include <string.h>
+#include "async_log.h"
+
+#define MAX_REPORT_DELTA 50  // Per-sample clamp to prevent jumping
+#define RECENTER_HOLD_NS 2000000000ULL  // Long press held this long recenters the absolute pointer
+
+static uint8_t button_mask(uint8_t button_state) {
+    if (button_state == 1) return MOTION_BUTTON_LEFT;
+    if (button_state == 2) return MOTION_BUTTON_RIGHT;
+    return 0;
+}
+
+// Quaternion of the body-to-sensor rotation for a mounting remap, so an
+// orientation fused on the device in sensor axes can be turned into body
+// axes with one multiply. Every alignment is a proper rotation.
+static FusionQuaternion remap_rotation(AxesRemap remap) {
+    // Rows are the remapped unit vectors: the transpose of the remap matrix
+    FusionMatrix m;
+    for (int i = 0; i < 3; i++) {
+        FusionVector unit = FUSION_VECTOR_ZERO;
+        unit.array[i] = 1.0f;
+        FusionVector row = remap(unit);
+        for (int j = 0; j < 3; j++) m.array[i][j] = row.array[j];
+    }
+
+#define M m.element
+    FusionQuaternion q;
+    float trace = M.xx + M.yy + M.zz;
+    if (trace > 0.0f) {
+        float s = 2.0f * sqrtf(1.0f + trace);
+        q = (FusionQuaternion){.element = {0.25f * s, (M.zy - M.yz) / s, (M.xz - M.zx) / s, (M.yx - M.xy) / s}};
+    } else if (M.xx > M.yy && M.xx > M.zz) {
+        float s = 2.0f * sqrtf(1.0f + M.xx - M.yy - M.zz);
+        q = (FusionQuaternion){.element = {(M.zy - M.yz) / s, 0.25f * s, (M.xy + M.yx) / s, (M.xz + M.zx) / s}};
+    } else if (M.yy > M.zz) {
+        float s = 2.0f * sqrtf(1.0f + M.yy - M.xx - M.zz);
+        q = (FusionQuaternion){.element = {(M.xz - M.zx) / s, (M.xy + M.yx) / s, 0.25f * s, (M.yz + M.zy) / s}};
+    } else {
+        float s = 2.0f * sqrtf(1.0f + M.zz - M.xx - M.yy);
+        q = (FusionQuaternion){.element = {(M.yx - M.xy) / s, (M.xz + M.zx) / s, (M.yz + M.zy) / s, 0.25f * s}};
+    }
+#undef M
+    return q;
+}
+
+void motion_pipeline_init(MotionPipeline* pipeline, const MouseConfig* pipeline_config) {
+    memset(pipeline, 0, sizeof(*pipeline));
+    pipeline->config = pipeline_config;
+    accel_curve_build(&pipeline->accel_curve, pipeline_config);
+    pipeline->remap = axes_remap_for(pipeline_config->mounting);
+    pipeline->mounting = remap_rotation(pipeline->remap);
+    motion_filter_init(&pipeline->filter, pipeline_config);
+    zupt_init(&pipeline->zupt);
+    gyro_offset_init(&pipeline->gyro_offset);
+
+    ImuCalibration identity;
+    imu_calibration_identity(&identity);
+    motion_pipeline_set_calibration(pipeline, &identity);
+}
+
+void motion_pipeline_set_calibration(MotionPipeline* pipeline, const ImuCalibration* calibration) {
+    calibration_fuse(&calibration->gyroscope, &pipeline->gyroscope_calibration);
+    calibration_fuse(&calibration->accelerometer, &pipeline->accelerometer_calibration);
+}
+
+// Start over from the next sample, e.g. after a reconnect. A button still
+// held is reported as released so the output device does not keep it down.
+// The gyro bias and calibration belong to the sensor, not the session, and
+// are kept.
+void motion_pipeline_reset(MotionPipeline* pipeline, MotionReport* report) {
+    if (report) {
+        memset(report, 0, sizeof(*report));
+        uint8_t held = button_mask(pipeline->button_state) & ~pipeline->held_back;
+        if (held) {
+            report->buttons[0].released = held;
+            report->button_count = 1;
+        }
+    }
+
+    GyroOffset gyro_offset = pipeline->gyro_offset;
+    FusedCalibration gyroscope_calibration = pipeline->gyroscope_calibration;
+    FusedCalibration accelerometer_calibration = pipeline->accelerometer_calibration;
+    MotionFilterStats filter_stats = pipeline->filter.stats;
+    motion_pipeline_init(pipeline, pipeline->config);
+    pipeline->filter.stats = filter_stats;
+    pipeline->gyro_offset = gyro_offset;
+    pipeline->gyroscope_calibration = gyroscope_calibration;
+    pipeline->accelerometer_calibration = accelerometer_calibration;
+}
+
+static int clamp_delta(int delta) {
+    if (delta > MAX_REPORT_DELTA) return MAX_REPORT_DELTA;
+    if (delta < -MAX_REPORT_DELTA) return -MAX_REPORT_DELTA;
+    return delta;
+}
+
+// Relative mode: double-integrate world-frame linear acceleration
+static void relative_motion(MotionPipeline* pipeline, FusionQuaternion quaternion, FusionVector linear_acceleration,
+                            float dt, MotionReport* report) {
+    // Transform linear acceleration from device frame to world frame using current orientation
+    // This makes movement independent of device rotation - move device left = cursor left
+    FusionMatrix rotation_matrix = FusionQuaternionToMatrix(quaternion);
+    FusionVector world_acceleration = FusionMatrixMultiplyVector(rotation_matrix, linear_acceleration);
+
+    // Debug: log sensor fusion values
+    unsigned int frame = ++pipeline->frames;
+    if (frame % 10 == 0) {  // Every 10 frames (~200ms)
+        FusionEuler euler = FusionQuaternionToEuler(quaternion);
+        ASYNC_LOG(LOG_DEBUG, "FUSION: Roll:%.1f° Pitch:%.1f° Yaw:%.1f° | WorldAccel(%.3f, %.3f, %.3f) dt:%.4f",
+               euler.angle.roll, euler.angle.pitch, euler.angle.yaw,
+               world_acceleration.axis.x, world_acceleration.axis.y, world_acceleration.axis.z, dt);
+    }
+
+    // Apply dead zone to filter small movements (in g units)
+    float dead_zone_g = pipeline->config->dead_zone;  // e.g., 0.03 g
+    if (fabsf(world_acceleration.axis.x) < dead_zone_g) world_acceleration.axis.x = 0.0f;
+    if (fabsf(world_acceleration.axis.y) < dead_zone_g) world_acceleration.axis.y = 0.0f;
+
+    // Map world-space acceleration to cursor velocity
+    // World X acceleration → horizontal cursor movement
+    // World Y acceleration → vertical cursor movement
+    // Z acceleration ignored (vertical in world frame)
+    float cursor_vel_x = world_acceleration.axis.x * pipeline->config->movement_sensitivity;  // World X → Screen X
+    float cursor_vel_y = -world_acceleration.axis.y * pipeline->config->movement_sensitivity; // World Y → Screen Y (inverted)
+
+    // Hold still when the device is at rest, and keep residual bias from
+    // turning into steady drift while it moves
+    zupt_filter_velocity(&pipeline->zupt, pipeline->config, &cursor_vel_x, &cursor_vel_y, dt);
+    if (pipeline->zupt.still) {
+        pipeline->cursor_x = 0.0f;
+        pipeline->cursor_y = 0.0f;
+    }
+    motion_filter_apply(&pipeline->filter, &cursor_vel_x, &cursor_vel_y, dt);
+
+    // Integrate velocity to position
+    pipeline->cursor_x += cursor_vel_x * dt;
+    pipeline->cursor_y += cursor_vel_y * dt;
+
+    // Debug velocity and accumulation
+    if (frame % 10 == 0) {
+        ASYNC_LOG(LOG_DEBUG, "VEL: (%.2f, %.2f) px/s | cursor_accum: (%.2f, %.2f) | sens:%.1f deadzone:%.3f g",
+               cursor_vel_x, cursor_vel_y,
+               pipeline->cursor_x, pipeline->cursor_y,
+               pipeline->config->movement_sensitivity, dead_zone_g);
+    }
+
+    // Extract integer deltas for mouse movement
+    int dx = (int)(pipeline->cursor_x);
+    int dy = (int)(pipeline->cursor_y);
+
+    // Subtract integer part from accumulated position (keep fractional part for smoothness)
+    pipeline->cursor_x -= (float)dx;
+    pipeline->cursor_y -= (float)dy;
+
+    // Apply invert settings
+    if (pipeline->config->invert_x) dx = -dx;
+    if (pipeline->config->invert_y) dy = -dy;
+
+    // Clamp to reasonable values to prevent jumping
+    dx = clamp_delta(dx);
+    dy = clamp_delta(dy);
+
+    // Log periodically (every 50 packets ~1 second)
+    if (frame % 50 == 0) {
+        ASYNC_LOG(LOG_DEBUG, "FUSION Angular Vel: (%.2f, %.2f) | Cursor: (%.2f, %.2f) -> dx:%d dy:%d",
+               cursor_vel_x, cursor_vel_y,
+               pipeline->cursor_x, pipeline->cursor_y,
+               dx, dy);
+    }
+
+    report->dx = dx;
+    report->dy = dy;
+}
+
+// Gyro mode: yaw and pitch rate through the acceleration curve. The rate
+// is what the hand does directly, so there is no integration drift and
+// slow turns stay precise.
+static void gyro_motion(MotionPipeline* pipeline, FusionVector gyroscope, float dt, MotionReport* report) {
+    const MouseConfig* cfg = pipeline->config;
+
+    // Turning left (positive about Up) moves left, nose down (positive
+    // about West) moves down
+    float rate_x = -gyroscope.axis.z;
+    float rate_y = gyroscope.axis.y;
+    float speed = sqrtf(rate_x * rate_x + rate_y * rate_y);
+
+    // Still samples go through the filter as zero velocity so it settles
+    float vel_x = 0.0f, vel_y = 0.0f;
+    if (speed >= cfg->gyro_dead_zone) {
+        float scale = accel_curve_gain(&pipeline->accel_curve, speed) * cfg->gyro_sensitivity;
+        vel_x = rate_x * scale;
+        vel_y = rate_y * scale;
+    }
+    motion_filter_apply(&pipeline->filter, &vel_x, &vel_y, dt);
+
+    pipeline->cursor_x += vel_x * dt;
+    pipeline->cursor_y += vel_y * dt;
+
+    int dx = (int)pipeline->cursor_x;
+    int dy = (int)pipeline->cursor_y;
+    pipeline->cursor_x -= (float)dx;
+    pipeline->cursor_y -= (float)dy;
+
+    if (cfg->invert_x) dx = -dx;
+    if (cfg->invert_y) dy = -dy;
+    report->dx = clamp_delta(dx);
+    report->dy = clamp_delta(dy);
+}
+
+static float wrap_degrees(float angle) {
+    while (angle > 180.0f) angle -= 360.0f;
+    while (angle < -180.0f) angle += 360.0f;
+    return angle;
+}
+
+static int scale_position(float position) {
+    if (position < 0.0f) position = 0.0f;
+    if (position > 1.0f) position = 1.0f;
+    return (int)lrintf(position * MOTION_ABS_MAX);
+}
+
+// Absolute mode: the orientation relative to the captured center maps
+// straight to a screen position, so nothing accumulates between samples
+static void absolute_position(MotionPipeline* pipeline, FusionQuaternion quaternion, MotionReport* report) {
+    const MouseConfig* cfg = pipeline->config;
+
+    // Wait for the AHRS to settle before taking the first center. The
+    // device only sends its orientation once its own AHRS has settled.
+    if (!pipeline->center_valid && !pipeline->fused && FusionAhrsGetFlags(&pipeline->ahrs).initialising) return;
+
+    FusionEuler euler = FusionQuaternionToEuler(quaternion);
+    if (!pipeline->center_valid || pipeline->recenter_pending) {
+        pipeline->center_yaw = euler.angle.yaw;
+        pipeline->center_pitch = euler.angle.pitch;
+        pipeline->center_valid = true;
+        pipeline->recenter_pending = false;
+        ASYNC_LOG(LOG_INFO, "Pointer centered at yaw %.1f°, pitch %.1f°", euler.angle.yaw, euler.angle.pitch);
+    }
+
+    // Yaw left (positive about Up) moves left, nose down (positive pitch) moves down
+    float x = 0.5f - wrap_degrees(euler.angle.yaw - pipeline->center_yaw) / cfg->absolute_yaw_range;
+    float y = 0.5f + (euler.angle.pitch - pipeline->center_pitch) / cfg->absolute_pitch_range;
+    if (cfg->invert_x) x = 1.0f - x;
+    if (cfg->invert_y) y = 1.0f - y;
+
+    int abs_x = scale_position(x);
+    int abs_y = scale_position(y);
+    if (pipeline->has_position && abs_x == pipeline->abs_x && abs_y == pipeline->abs_y) return;
+
+    pipeline->abs_x = abs_x;
+    pipeline->abs_y = abs_y;
+    pipeline->has_position = true;
+    report->abs_x = abs_x;
+    report->abs_y = abs_y;
+    report->has_position = true;
+}
+
+static void add_button_change(MotionReport* report, uint8_t pressed, uint8_t released) {
+    if ((!pressed && !released) || report->button_count >= MOTION_BUTTON_CHANGES) return;
+
+    ButtonChange* change = &report->buttons[report->button_count++];
+    change->pressed = pressed;
+    change->released = released;
+}
+
+// 0=none, 1=press (left), 2=long press (right)
+static void button_transition(MotionPipeline* pipeline, uint8_t state, uint64_t arrival_ns, MotionReport* report) {
+    if (state == pipeline->button_state) return;
+
+    // A held-back long press let go before the recenter hold was a right
+    // click after all; one that recentered never reaches the output
+    uint8_t released = button_mask(pipeline->button_state);
+    if (pipeline->held_back) {
+        if (pipeline->recenter_armed) {
+            add_button_change(report, pipeline->held_back, 0);
+        } else {
+            released &= ~pipeline->held_back;
+        }
+        pipeline->held_back = 0;
+    }
+
+    // In absolute mode a long press may be the recenter gesture, so the
+    // right button waits until it is clear which of the two it is
+    uint8_t pressed = button_mask(state);
+    if (state == 2 && pipeline->config->pointer_mode == POINTER_MODE_ABSOLUTE) {
+        pipeline->held_back = pressed;
+        pressed = 0;
+    }
+    add_button_change(report, pressed, released);
+
+    if (state == 1) {
+        ASYNC_LOG(LOG_INFO, "Left button pressed");
+    } else if (state == 2) {
+        ASYNC_LOG(LOG_INFO, "Right button pressed");
+    } else if (state == 0) {
+        ASYNC_LOG(LOG_INFO, "Button released");
+    }
+
+    pipeline->button_state = state;
+    pipeline->button_since_ns = arrival_ns;
+    pipeline->recenter_armed = state == 2;
+}
+
+static const ButtonEventRecord* find_button_event(const ButtonEventHistory* history, uint8_t sequence) {
+    for (int i = 0; i < BUTTON_EVENT_HISTORY; i++) {
+        if (history->events[i].sequence == sequence) return &history->events[i];
+    }
+    return NULL;
+}
+
+// Button changes are numbered by the firmware. Every packet carries the
+// current state and the number of the latest change, and frames repeat the
+// last few changes, so changes whose packets were lost are replayed in
+// order and each one is applied exactly once.
+static void update_buttons(MotionPipeline* pipeline, const SensorSample* sample, MotionReport* report) {
+    const SensorPacket* packet = &sample->packet;
+    uint8_t sequence = packet->button_sequence;
+
+    if (pipeline->button_sequence_valid && sequence != pipeline->button_sequence) {
+        uint8_t missed = sequence - pipeline->button_sequence;
+        bool complete = missed <= BUTTON_EVENT_HISTORY && sample->has_button_history;
+
+        for (uint8_t i = 1; complete && i <= missed; i++) {
+            const ButtonEventRecord* event =
+                find_button_event(&sample->button_history, (uint8_t)(pipeline->button_sequence + i));
+            if (!event) {
+                complete = false;
+                break;
+            }
+            button_transition(pipeline, event->state, sample->arrival_ns, report);
+        }
+
+        // Without the history a lost press and release only show up as
+        // the count moving while the state stayed released: most likely a
+        // click, the only gesture short enough to vanish completely
+        if (!complete && packet->button_state == 0 && pipeline->button_state == 0 && missed >= 2) {
+            button_transition(pipeline, 1, sample->arrival_ns, report);
+            ASYNC_LOG(LOG_INFO, "Recovered a lost click (%u button changes missed)", missed);
+        }
+    }
+    pipeline->button_sequence = sequence;
+    pipeline->button_sequence_valid = true;
+
+    // The state in the packet is authoritative, also for firmware without
+    // sequence numbers
+    button_transition(pipeline, packet->button_state, sample->arrival_ns, report);
+}
+
+// Orientation and linear acceleration from a version 4 sample, turned from
+// the device's sensor axes into body axes
+static void fused_orientation(const MotionPipeline* pipeline, const SensorSample* sample,
+                              FusionQuaternion* quaternion, FusionVector* linear_acceleration) {
+    FusedPacket packet;
+    memcpy(&packet, &sample->packet, sizeof(packet));
+
+    // Only the vector part is sent; w is the non-negative remainder
+    float x = packet.quat_x / FUSED_QUATERNION_SCALE;
+    float y = packet.quat_y / FUSED_QUATERNION_SCALE;
+    float z = packet.quat_z / FUSED_QUATERNION_SCALE;
+    float w_squared = 1.0f - x * x - y * y - z * z;
+    FusionQuaternion sensor = {.element = {w_squared > 0.0f ? sqrtf(w_squared) : 0.0f, x, y, z}};
+    *quaternion = FusionQuaternionMultiply(FusionQuaternionNormalise(sensor), pipeline->mounting);
+
+    FusionVector linear = {.axis = {
+        packet.linear_x / FUSED_LINEAR_SCALE,
+        packet.linear_y / FUSED_LINEAR_SCALE,
+        packet.linear_z / FUSED_LINEAR_SCALE
+    }};
+    *linear_acceleration = pipeline->remap(linear);
+}
+
+// Gravity in body axes, as FusionAhrsGetGravity() computes it
+static FusionVector quaternion_gravity(FusionQuaternion quaternion) {
+#define Q quaternion.element
+    return (FusionVector){.axis = {
+        2.0f * (Q.x * Q.z - Q.w * Q.y),
+        2.0f * (Q.y * Q.z + Q.w * Q.x),
+        2.0f * (Q.w * Q.w - 0.5f + Q.z * Q.z)
+    }};
+#undef Q
+}
+
+// Body-frame angular rate (deg/s) that turns one orientation into the next
+static FusionVector quaternion_rate(FusionQuaternion previous, FusionQuaternion current, float dt) {
+    FusionQuaternion inverse = {.element = {previous.element.w, -previous.element.x,
+                                            -previous.element.y, -previous.element.z}};
+    FusionQuaternion delta = FusionQuaternionMultiply(inverse, current);
+
+    // q and -q are the same rotation: take the short way round
+    float sign = delta.element.w < 0.0f ? -1.0f : 1.0f;
+    float scale = sign * FusionRadiansToDegrees(2.0f) / dt;
+    return (FusionVector){.axis = {delta.element.x * scale, delta.element.y * scale, delta.element.z * scale}};
+}
+
+// Feed one sample. Returns true when the report holds motion or button
+// changes for the output device.
+bool motion_pipeline_process(MotionPipeline* pipeline, const SensorSample* sample, MotionReport* report) {
+    memset(report, 0, sizeof(*report));
+
+    update_buttons(pipeline, sample, report);
+
+    // Recenter gesture: keep the long press held
+    if (pipeline->recenter_armed && sample->arrival_ns - pipeline->button_since_ns >= RECENTER_HOLD_NS) {
+        pipeline->recenter_armed = false;
+        pipeline->recenter_pending = true;
+    }
+    bool has_buttons = report->button_count > 0;
+
+    FusionVector gyroscope = FUSION_VECTOR_ZERO;
+    FusionVector accelerometer = FUSION_VECTOR_ZERO;
+    FusionVector linear_acceleration = FUSION_VECTOR_ZERO;
+    FusionQuaternion quaternion = FUSION_IDENTITY_QUATERNION;
+
+    if (sample->fused) {
+        fused_orientation(pipeline, sample, &quaternion, &linear_acceleration);
+    } else {
+        // Offset, sensitivity and misalignment as one precomputed multiply-add
+        gyroscope = calibration_apply(&pipeline->gyroscope_calibration, sample->gyroscope);
+        accelerometer = calibration_apply(&pipeline->accelerometer_calibration, sample->accelerometer);
+
+        // Mounting orientation, resolved once at init
+        gyroscope = pipeline->remap(gyroscope);
+        accelerometer = pipeline->remap(accelerometer);
+    }
+
+    // Device counter: bare packets carry 16 bits of milliseconds, frames
+    // 32 bits of microseconds (milliseconds from older firmware)
+    if (!pipeline->initialized || pipeline->time_bits != sample->time_bits || pipeline->tick_hz != sample->tick_hz) {
+        timebase_init(&pipeline->timebase, sample->tick_hz, sample->time_bits);
+        pipeline->time_bits = sample->time_bits;
+        pipeline->tick_hz = sample->tick_hz;
+    }
+
+    // Firmware falls back to raw samples when the MTU is too small for
+    // frames. The two orientations have unrelated headings, so start over.
+    if (pipeline->initialized && sample->fused != pipeline->fused) {
+        ASYNC_LOG(LOG_INFO, sample->fused ? "Device switched to on-board fusion" : "Device switched to raw samples");
+        pipeline->initialized = false;
+        pipeline->center_valid = false;
+    }
+
+    if (!pipeline->initialized) {
+        timebase_update(&pipeline->timebase, sample->device_time, sample->arrival_ns);
+
+        // Initialize Fusion AHRS
+        FusionAhrsInitialise(&pipeline->ahrs);
+
+        // Set AHRS settings optimized for fast, accurate mouse control
+        FusionAhrsSettings settings = {
+            .convention = FusionConventionNwu,        // North-West-Up coordinate system
+            .gain = 1.0f,                            // Higher gain for faster convergence
+            .gyroscopeRange = 2000.0f,               // ±2000 degrees/s range
+            .accelerationRejection = 10.0f,          // Lower rejection for mouse movements
+            .magneticRejection = 0.0f,               // No magnetometer
+            .recoveryTriggerPeriod = 2 * 200         // 2 seconds at 200Hz (faster recovery)
+        };
+        FusionAhrsSetSettings(&pipeline->ahrs, &settings);
+
+        pipeline->fused = sample->fused;
+        pipeline->last_quaternion = quaternion;
+        pipeline->cursor_x = 0.0f;
+        pipeline->cursor_y = 0.0f;
+        scroll_engine_reset(&pipeline->scroll);
+        pipeline->initialized = true;
+        return has_buttons;  // Skip first frame
+    }
+
+    // Integrate on the device's sample clock rather than host arrival time,
+    // which is bunched up by BLE connection intervals and D-Bus batching
+    float dt = timebase_update(&pipeline->timebase, sample->device_time, sample->arrival_ns);
+
+    FusionVector gravity;
+    if (pipeline->fused) {
+        // The device already removed the bias and fused; recover what the
+        // gyro and accelerometer would have read for gyro mode and ZUPT
+        gravity = quaternion_gravity(quaternion);
+        gyroscope = quaternion_rate(pipeline->last_quaternion, quaternion, dt);
+        accelerometer = FusionVectorAdd(linear_acceleration, gravity);
+        pipeline->last_quaternion = quaternion;
+    } else {
+        // Remove the gyro bias before it turns into orientation drift
+        gyroscope = gyro_offset_update(&pipeline->gyro_offset, gyroscope, dt);
+
+        // Update AHRS with sensor data (no magnetometer)
+        FusionAhrsUpdateNoMagnetometer(&pipeline->ahrs, gyroscope, accelerometer, dt);
+
+        quaternion = FusionAhrsGetQuaternion(&pipeline->ahrs);
+        linear_acceleration = FusionAhrsGetLinearAcceleration(&pipeline->ahrs);
+        gravity = FusionAhrsGetGravity(&pipeline->ahrs);
+    }
+
+    if (pipeline->config->pointer_mode == POINTER_MODE_ABSOLUTE) {
+        absolute_position(pipeline, quaternion, report);
+        return has_buttons || report->has_position;
+    }
+    if (pipeline->config->pointer_mode == POINTER_MODE_GYRO) {
+        gyro_motion(pipeline, gyroscope, dt, report);
+        return has_buttons || report->dx != 0 || report->dy != 0;
+    }
+
+    zupt_update(&pipeline->zupt, pipeline->config, gyroscope, accelerometer);
+    relative_motion(pipeline, quaternion, linear_acceleration, dt, report);
+
+    bool has_scroll = scroll_engine_update(&pipeline->scroll, pipeline->config, gravity, dt, &report->scroll);
+
+    // Tilting to scroll also rotates the linear acceleration; hold the
+    // cursor instead of letting it wander while the wheel turns
+    if (pipeline->scroll.active) {
+        report->dx = 0;
+        report->dy = 0;
+        pipeline->cursor_x = 0.0f;
+        pipeline->cursor_y = 0.0f;
+    }
+
+    return has_buttons || has_scroll || report->dx != 0 || report->dy != 0;
+}
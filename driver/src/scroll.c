@@ -0,0 +1,76 @@
+#include "scroll.h"
+#include <math.h>
+#include <string.h>
+
+void scroll_engine_reset(ScrollEngine* engine) {
+    memset(engine, 0, sizeof(*engine));
+}
+
+// Running moving average over the last `samples` tilt values
+static float filter_tilt(ScrollAxis* axis, float tilt, int samples) {
+    if (samples < 1) samples = 1;
+    if (samples > SCROLL_FILTER_MAX) samples = SCROLL_FILTER_MAX;
+
+    if (axis->history_len != samples) {
+        // Window size changed: restart from the current value
+        for (int i = 0; i < samples; i++) axis->history[i] = tilt;
+        axis->history_sum = tilt * samples;
+        axis->history_len = samples;
+        axis->history_pos = 0;
+    }
+
+    axis->history_sum += tilt - axis->history[axis->history_pos];
+    axis->history[axis->history_pos] = tilt;
+    axis->history_pos = (axis->history_pos + 1) % samples;
+    return axis->history_sum / samples;
+}
+
+// Returns true while the tilt is beyond the threshold
+static bool update_axis(ScrollAxis* axis, const MouseConfig* cfg, float tilt, float dt, int* hires, int* detents) {
+    float filtered = filter_tilt(axis, tilt, cfg->scroll_filter_samples);
+    float excess = fabsf(filtered) - cfg->scroll_threshold;
+
+    *hires = 0;
+    *detents = 0;
+
+    if (excess <= 0.0f) {
+        // Back inside the neutral zone: drop the fraction so it cannot fire later
+        axis->hires_accum = 0.0f;
+        return false;
+    }
+
+    // Speed grows with tilt beyond the threshold
+    float rate = copysignf(excess, filtered) * SCROLL_DETENTS_PER_G * cfg->scroll_sensitivity;
+    if (cfg->invert_scroll) rate = -rate;
+    axis->hires_accum += rate * SCROLL_HIRES_PER_DETENT * dt;
+
+    if (fabsf(axis->hires_accum) < SCROLL_MIN_HIRES_STEP) return true;
+
+    int units = (int)axis->hires_accum;
+    axis->hires_accum -= (float)units;
+    *hires = units;
+
+    // Legacy wheel clicks every full detent of hi-res motion
+    axis->detent_accum += units;
+    *detents = axis->detent_accum / SCROLL_HIRES_PER_DETENT;
+    axis->detent_accum -= *detents * SCROLL_HIRES_PER_DETENT;
+    return true;
+}
+
+// Gravity is the AHRS up vector in the sensor frame: nose up tilts it
+// towards +x (scroll up), left side up towards +y (scroll right). Returns
+// true when the output holds any wheel motion; engine->active tells whether
+// the device is tilted into scrolling at all.
+bool scroll_engine_update(ScrollEngine* engine, const MouseConfig* cfg, FusionVector gravity, float dt,
+                          ScrollOutput* output) {
+    memset(output, 0, sizeof(*output));
+    engine->active = false;
+    if (!cfg->scroll_enabled || cfg->scroll_sensitivity <= 0.0f) return false;
+
+    bool vertical = update_axis(&engine->vertical, cfg, gravity.axis.x, dt, &output->wheel_hi_res, &output->wheel);
+    bool horizontal = update_axis(&engine->horizontal, cfg, gravity.axis.y, dt, &output->hwheel_hi_res,
+                                  &output->hwheel);
+    engine->active = vertical || horizontal;
+
+    return output->wheel_hi_res != 0 || output->hwheel_hi_res != 0;
+}
@@ -0,0 +1,98 @@
+#include "timebase.h"
+#include <math.h>
+#include "async_log.h"
+
+static float clamp_dt(double dt) {
+    if (dt < TIMEBASE_MIN_DT) return TIMEBASE_MIN_DT;
+    if (dt > TIMEBASE_MAX_DT) return TIMEBASE_MAX_DT;
+    return (float)dt;
+}
+
+static void restart_drift_window(DeviceTimebase* tb, uint64_t host_ns) {
+    tb->window_device_s = 0.0;
+    tb->window_start_ns = host_ns;
+}
+
+static void set_host_fallback(DeviceTimebase* tb, bool enabled) {
+    if (tb->host_fallback == enabled) return;
+    tb->host_fallback = enabled;
+    ASYNC_LOG(LOG_INFO, enabled ? "Device timestamps stalled, integrating on host time"
+                             : "Device timestamps resumed");
+}
+
+void timebase_init(DeviceTimebase* tb, uint32_t tick_hz, unsigned int counter_bits) {
+    tb->tick_hz = tick_hz;
+    tb->wrap_mask = counter_bits >= 32 ? 0xFFFFFFFFu : (1u << counter_bits) - 1u;
+    tb->last_ticks = 0;
+    tb->last_host_ns = 0;
+    tb->last_advance_ns = 0;
+    tb->drift = 1.0;
+    tb->window_device_s = 0.0;
+    tb->window_start_ns = 0;
+    tb->outliers = 0;
+    tb->host_fallback = false;
+    tb->initialized = false;
+}
+
+// Returns the integration interval in seconds for a sample stamped with
+// device_ticks that reached the host at host_ns.
+float timebase_update(DeviceTimebase* tb, uint32_t device_ticks, uint64_t host_ns) {
+    device_ticks &= tb->wrap_mask;
+
+    if (!tb->initialized) {
+        tb->last_ticks = device_ticks;
+        tb->last_host_ns = host_ns;
+        tb->last_advance_ns = host_ns;
+        restart_drift_window(tb, host_ns);
+        tb->initialized = true;
+        return TIMEBASE_NOMINAL_DT;
+    }
+
+    double host_dt = (host_ns - tb->last_host_ns) * 1e-9;
+    uint32_t delta_ticks = (device_ticks - tb->last_ticks) & tb->wrap_mask;
+    double device_dt = (double)delta_ticks / tb->tick_hz;
+
+    tb->last_host_ns = host_ns;
+    tb->last_ticks = device_ticks;
+
+    // After a long silence the wrapped counter is ambiguous: resync on host time
+    if (host_dt > TIMEBASE_RESYNC_S) {
+        tb->last_advance_ns = host_ns;
+        restart_drift_window(tb, host_ns);
+        return clamp_dt(host_dt);
+    }
+
+    // Device counter frozen (or firmware without timestamps)
+    if (delta_ticks == 0) {
+        if ((host_ns - tb->last_advance_ns) * 1e-9 > TIMEBASE_STALL_S) {
+            set_host_fallback(tb, true);
+        }
+        return tb->host_fallback ? clamp_dt(host_dt) : TIMEBASE_MIN_DT;
+    }
+
+    tb->last_advance_ns = host_ns;
+    if (tb->host_fallback) {
+        set_host_fallback(tb, false);
+        restart_drift_window(tb, host_ns);
+    }
+
+    // Backwards steps show up as huge forward deltas after masking
+    if (device_dt > TIMEBASE_MAX_DT) {
+        tb->outliers++;
+        restart_drift_window(tb, host_ns);
+        return clamp_dt(host_dt);
+    }
+
+    // Estimate the device/host clock ratio over a long window so bursty
+    // delivery averages out
+    tb->window_device_s += device_dt;
+    if (tb->window_device_s >= TIMEBASE_DRIFT_WINDOW) {
+        double ratio = (host_ns - tb->window_start_ns) * 1e-9 / tb->window_device_s;
+        if (fabs(ratio - 1.0) <= TIMEBASE_DRIFT_LIMIT) {
+            tb->drift = 0.8 * tb->drift + 0.2 * ratio;
+        }
+        restart_drift_window(tb, host_ns);
+    }
+
+    return clamp_dt(device_dt * tb->drift);
+}
@@ -0,0 +1,58 @@
+#define _GNU_SOURCE
+#include "timing.h"
+#include <string.h>
+#include <syslog.h>
+#include <time.h>
+
+uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t process_cpu_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void latency_histogram_reset(LatencyHistogram* hist) {
+    memset(hist, 0, sizeof(*hist));
+}
+
+void latency_histogram_record(LatencyHistogram* hist, uint64_t latency_ns) {
+    uint64_t bucket = latency_ns / (LATENCY_BUCKET_US * 1000ULL);
+    if (bucket > LATENCY_BUCKETS) bucket = LATENCY_BUCKETS;
+
+    hist->buckets[bucket]++;
+    hist->count++;
+    if (latency_ns > hist->max_ns) hist->max_ns = latency_ns;
+}
+
+// Upper edge of the bucket containing the given percentile (0-100), in ms
+double latency_histogram_percentile_ms(const LatencyHistogram* hist, double percentile) {
+    if (hist->count == 0) return 0.0;
+
+    uint64_t target = (uint64_t)((percentile / 100.0) * hist->count + 0.5);
+    if (target == 0) target = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i <= LATENCY_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= target) {
+            if (i == LATENCY_BUCKETS) return hist->max_ns / 1e6;
+            return (i + 1) * LATENCY_BUCKET_US / 1000.0;
+        }
+    }
+    return hist->max_ns / 1e6;
+}
+
+void latency_histogram_log(const LatencyHistogram* hist, const char* label) {
+    if (hist->count == 0) return;
+
+    syslog(LOG_INFO, "%s latency over %u packets: median %.2f ms, p99 %.2f ms, max %.2f ms",
+           label, hist->count,
+           latency_histogram_percentile_ms(hist, 50.0),
+           latency_histogram_percentile_ms(hist, 99.0),
+           hist->max_ns / 1e6);
+}
@@ -0,0 +1,76 @@
+#include "zupt.h"
+#include <string.h>
+#include "async_log.h"
+
+void running_variance_reset(RunningVariance* rv) {
+    memset(rv, 0, sizeof(*rv));
+}
+
+void running_variance_push(RunningVariance* rv, float value) {
+    if (rv->count == ZUPT_WINDOW) {
+        float oldest = rv->values[rv->head];
+        rv->sum -= oldest;
+        rv->sum_sq -= (double)oldest * oldest;
+    } else {
+        rv->count++;
+    }
+
+    rv->values[rv->head] = value;
+    rv->sum += value;
+    rv->sum_sq += (double)value * value;
+    rv->head = (rv->head + 1) % ZUPT_WINDOW;
+}
+
+float running_variance_get(const RunningVariance* rv) {
+    if (rv->count < 2) return 0.0f;
+
+    double mean = rv->sum / rv->count;
+    double variance = rv->sum_sq / rv->count - mean * mean;
+    return variance > 0.0 ? (float)variance : 0.0f;
+}
+
+void zupt_init(Zupt* zupt) {
+    memset(zupt, 0, sizeof(*zupt));
+}
+
+// Still when the device is barely rotating and the accelerometer has held a
+// steady magnitude over the whole window
+bool zupt_update(Zupt* zupt, const MouseConfig* cfg, FusionVector gyroscope, FusionVector accelerometer) {
+    running_variance_push(&zupt->accel, FusionVectorMagnitude(accelerometer));
+
+    float accel_limit = cfg->zupt_accel_stddev * cfg->zupt_accel_stddev;
+    bool still = zupt->accel.count == ZUPT_WINDOW &&
+                 FusionVectorMagnitude(gyroscope) < cfg->zupt_gyro_threshold &&
+                 running_variance_get(&zupt->accel) < accel_limit;
+
+    if (still != zupt->still) {
+        zupt->still = still;
+        ASYNC_LOG(LOG_DEBUG, still ? "ZUPT: still" : "ZUPT: moving");
+    }
+    return still;
+}
+
+// Zero-velocity update while still, otherwise a first-order high-pass with
+// time constant velocity_highpass so a constant residual acceleration decays
+// instead of dragging the cursor
+void zupt_filter_velocity(Zupt* zupt, const MouseConfig* cfg, float* vel_x, float* vel_y, float dt) {
+    float* vel[2] = {vel_x, vel_y};
+
+    if (zupt->still) {
+        for (int i = 0; i < 2; i++) {
+            zupt->highpass_in[i] = *vel[i];
+            zupt->highpass_out[i] = 0.0f;
+            *vel[i] = 0.0f;
+        }
+        return;
+    }
+    if (cfg->velocity_highpass <= 0.0f) return;
+
+    float alpha = cfg->velocity_highpass / (cfg->velocity_highpass + dt);
+    for (int i = 0; i < 2; i++) {
+        float out = alpha * (zupt->highpass_out[i] + *vel[i] - zupt->highpass_in[i]);
+        zupt->highpass_in[i] = *vel[i];
+        zupt->highpass_out[i] = out;
+        *vel[i] = out;
+    }
+}
@@ -0,0 +1,124 @@
+// The notification handler and decoder are internal to bluetooth.c, so the
+// bench compiles that file in directly
+#include "../src/bluetooth.c"
+#include "check.h"
+#include "synthetic_frames.h"
+
+#define BENCH_NOTIFICATIONS 50000
+#define CHAR_PATH   "/org/bluez/hci0/dev_00_11_22_33_44_55/service0010/char0011"
+#define DEVICE_PATH "/org/bluez/hci0/dev_00_11_22_33_44_55"
+
+bool running = true;
+MouseConfig config;
+
+// A PropertiesChanged signal carrying the payload as the characteristic's
+// new Value, as BlueZ emits it for every notification without AcquireNotify
+static DBusMessage* value_changed_signal(const uint8_t* payload, size_t length) {
+    DBusMessage* msg = dbus_message_new_signal(CHAR_PATH, "org.freedesktop.DBus.Properties", "PropertiesChanged");
+    DBusMessageIter iter, changed, entry, variant, array, invalidated;
+    const char* interface = "org.bluez.GattCharacteristic1";
+    const char* property = "Value";
+
+    dbus_message_iter_init_append(msg, &iter);
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &interface);
+    dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{sv}", &changed);
+    dbus_message_iter_open_container(&changed, DBUS_TYPE_DICT_ENTRY, NULL, &entry);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &property);
+    dbus_message_iter_open_container(&entry, DBUS_TYPE_VARIANT, "ay", &variant);
+    dbus_message_iter_open_container(&variant, DBUS_TYPE_ARRAY, "y", &array);
+    dbus_message_iter_append_fixed_array(&array, DBUS_TYPE_BYTE, &payload, (int)length);
+    dbus_message_iter_close_container(&variant, &array);
+    dbus_message_iter_close_container(&entry, &variant);
+    dbus_message_iter_close_container(&changed, &entry);
+    dbus_message_iter_close_container(&iter, &changed);
+    dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "s", &invalidated);
+    dbus_message_iter_close_container(&iter, &invalidated);
+    return msg;
+}
+
+// The handler as it was before in-place decoding: the Value array walked
+// with one get_basic per byte into a stack buffer, then decoded from there
+static void per_byte_handler(DBusMessage* msg, BLEConnection* conn) {
+    DBusMessageIter iter, dict_iter, entry_iter, variant_iter, array_iter;
+    dbus_message_iter_init(msg, &iter);
+    dbus_message_iter_next(&iter);
+    dbus_message_iter_recurse(&iter, &dict_iter);
+
+    while (dbus_message_iter_get_arg_type(&dict_iter) == DBUS_TYPE_DICT_ENTRY) {
+        dbus_message_iter_recurse(&dict_iter, &entry_iter);
+        char* prop_name;
+        dbus_message_iter_get_basic(&entry_iter, &prop_name);
+
+        if (strcmp(prop_name, "Value") == 0) {
+            dbus_message_iter_next(&entry_iter);
+            dbus_message_iter_recurse(&entry_iter, &variant_iter);
+            if (dbus_message_iter_get_arg_type(&variant_iter) == DBUS_TYPE_ARRAY) {
+                dbus_message_iter_recurse(&variant_iter, &array_iter);
+
+                uint8_t buffer[SENSOR_NOTIFY_MAX_LEN];
+                int idx = 0;
+                while (dbus_message_iter_get_arg_type(&array_iter) == DBUS_TYPE_BYTE && idx < (int)sizeof(buffer)) {
+                    dbus_message_iter_get_basic(&array_iter, &buffer[idx++]);
+                    dbus_message_iter_next(&array_iter);
+                }
+                if (idx > 0) decode_notification(conn, buffer, idx, monotonic_ns());
+            }
+        }
+        dbus_message_iter_next(&dict_iter);
+    }
+}
+
+static void bench_connection(BLEConnection* conn) {
+    memset(conn, 0, sizeof(*conn));
+    snprintf(conn->device_path, sizeof(conn->device_path), "%s", DEVICE_PATH);
+    snprintf(conn->char_path, sizeof(conn->char_path), "%s", CHAR_PATH);
+    conn->connected = true;
+    conn->notify_fd = -1;
+    packet_queue_init(&conn->queue);
+}
+
+// Runs one message through a handler BENCH_NOTIFICATIONS times, emptying
+// the queue after each like the consumer would. Returns CPU ns per
+// notification.
+static double time_handler(DBusMessage* msg, bool in_place, unsigned int samples) {
+    BLEConnection conn;
+    bench_connection(&conn);
+
+    uint64_t start = process_cpu_ns();
+    for (unsigned int i = 0; i < BENCH_NOTIFICATIONS; i++) {
+        if (in_place) {
+            notification_handler(NULL, msg, &conn);
+        } else {
+            per_byte_handler(msg, &conn);
+        }
+        conn.queue.tail = conn.queue.head;
+    }
+    uint64_t elapsed = process_cpu_ns() - start;
+
+    CHECK(conn.queue.dropped == 0);
+    CHECK(conn.samples == (uint64_t)BENCH_NOTIFICATIONS * samples);
+    return (double)elapsed / BENCH_NOTIFICATIONS;
+}
+
+static void bench_payload(const char* name, const uint8_t* payload, size_t length, unsigned int samples) {
+    DBusMessage* msg = value_changed_signal(payload, length);
+    double per_byte = time_handler(msg, false, samples);
+    double in_place = time_handler(msg, true, samples);
+    dbus_message_unref(msg);
+
+    printf("  %-16s %4zu B  %2u   %7.0f ns  %7.0f ns  %6.1f ns  %5.2fx\n", name, length, samples, per_byte, in_place,
+           in_place / samples, per_byte / in_place);
+}
+
+int main() {
+    uint8_t payload[SENSOR_NOTIFY_MAX_LEN];
+
+    printf("decode bench: PropertiesChanged Value signals, %d notifications each\n", BENCH_NOTIFICATIONS);
+    printf("  payload          bytes  n    per-byte    in place   /sample   speedup\n");
+    bench_payload("bare packet", payload, synthetic_bare_packet(payload, 0), 1);
+    bench_payload("v3 frame", payload, synthetic_v3_frame(payload, 0, 4), 4);
+    bench_payload("v3 frame, full", payload, synthetic_v3_frame(payload, 0, 30), 30);
+    bench_payload("v5 frame", payload, synthetic_v5_frame(payload, 0, 4), 4);
+    bench_payload("v5 frame, full", payload, synthetic_v5_frame(payload, 0, 30), 30);
+    return check_report("decode bench");
+}
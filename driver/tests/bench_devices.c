@@ -0,0 +1,171 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "check.h"
+#include "common.h"
+#include "packet_queue.h"
+#include "pipeline.h"
+#include "timing.h"
+#include "uinput.h"
+
+#define BENCH_SECONDS     30
+#define SAMPLE_RATE_HZ    200
+#define SAMPLES_PER_FRAME 4    // The firmware's default SENSOR_BATCH_SIZE
+
+// The pipeline reads state_dir through the global configuration; the bench
+// persists nothing
+MouseConfig config;
+
+static const int device_counts[] = {1, 4, 16, 48};
+
+static const PointerMode modes[] = {POINTER_MODE_RELATIVE, POINTER_MODE_GYRO, POINTER_MODE_ABSOLUTE};
+static const char* mode_names[] = {"relative", "gyro", "absolute"};
+
+// What the daemon keeps per controller, minus the BLE link: a MouseDevice
+// reduced to its queue, pipeline and output
+typedef struct {
+    MouseConfig config;
+    PacketQueue queue;
+    MotionPipeline pipeline;
+    UInputDevice uinput;
+    uint32_t time_us;
+    uint8_t button_state;
+    uint8_t button_sequence;
+} SimulatedDevice;
+
+static MouseConfig bench_config(PointerMode mode) {
+    MouseConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.pointer_mode = mode;
+    cfg.mounting = FusionAxesAlignmentPXPYPZ;
+    cfg.absolute_yaw_range = 60.0f;
+    cfg.absolute_pitch_range = 40.0f;
+    cfg.gyro_sensitivity = 1.0f;
+    cfg.gyro_dead_zone = 1.5f;
+    cfg.accel_profile = ACCEL_PROFILE_ADAPTIVE;
+    cfg.accel_threshold = 60.0f;
+    cfg.accel_max_gain = 4.0f;
+    cfg.accel_exponent = 1.5f;
+    cfg.motion_filter = MOTION_FILTER_ONE_EURO;
+    cfg.filter_min_cutoff = 1.0f;
+    cfg.filter_beta = 0.02f;
+    cfg.filter_d_cutoff = 1.0f;
+    cfg.filter_process_noise = 5000.0f;
+    cfg.filter_measurement_noise = 25.0f;
+    cfg.zupt_gyro_threshold = 3.0f;
+    cfg.zupt_accel_stddev = 0.02f;
+    cfg.velocity_highpass = 0.5f;
+    cfg.movement_sensitivity = 2.0f;
+    cfg.scroll_enabled = true;  // Keep the tilt in the sweep on the scroll path
+    cfg.scroll_sensitivity = 1.0f;
+    cfg.dead_zone = 0.05f;
+    cfg.scroll_threshold = 0.3f;
+    cfg.scroll_filter_samples = 5;
+    return cfg;
+}
+
+// One version 3 notification decoded in place into the device's queue, as
+// decode_notification does: a slow sweep with a tilt, each device out of
+// phase with the others, and a click every two seconds
+static void receive_frame(SimulatedDevice* device, int index, uint64_t arrival_ns) {
+    for (int i = 0; i < SAMPLES_PER_FRAME; i++) {
+        SensorSample* slot = packet_queue_reserve(&device->queue);
+        if (!slot) return;
+
+        float t = device->time_us / 1e6f + index * 0.37f;
+        uint8_t state = fmodf(t, 2.0f) < 0.1f ? 1 : 0;
+        if (state != device->button_state) {
+            device->button_state = state;
+            device->button_sequence++;
+        }
+
+        memset(slot, 0, sizeof(*slot));
+        slot->accelerometer = (FusionVector){.axis = {0.3f * sinf(t * 1.1f), 0.2f * sinf(t * 0.7f + 1.0f),
+                                                      0.95f + 0.05f * cosf(t * 1.3f)}};
+        slot->gyroscope = (FusionVector){.axis = {20.0f * sinf(t * 2.0f), 35.0f * cosf(t * 1.5f),
+                                                  50.0f * sinf(t * 0.9f + 0.5f)}};
+        slot->packet.button_state = device->button_state;
+        slot->packet.button_sequence = device->button_sequence;
+        slot->packet.timestamp = (uint16_t)device->time_us;
+        slot->device_time = device->time_us;
+        slot->tick_hz = 1000000;
+        slot->time_bits = 32;
+        slot->arrival_ns = arrival_ns;
+        slot->has_button_history = true;
+        slot->button_history.events[BUTTON_EVENT_HISTORY - 1].sequence = device->button_sequence;
+        slot->button_history.events[BUTTON_EVENT_HISTORY - 1].state = device->button_state;
+        packet_queue_commit(&device->queue);
+        device->time_us += 1000000 / SAMPLE_RATE_HZ;
+    }
+}
+
+// The body of device_samples_ready()
+static unsigned int drain(SimulatedDevice* device) {
+    SensorSample sample;
+    unsigned int samples = 0;
+    while (packet_queue_pop(&device->queue, &sample)) {
+        MotionReport report;
+        if (motion_pipeline_process(&device->pipeline, &sample, &report)) {
+            emit_motion_report(&device->uinput, &report);
+        }
+        samples++;
+    }
+    return samples;
+}
+
+static void bench_devices(int fd, PointerMode mode, const char* mode_name, int count) {
+    SimulatedDevice* devices = calloc(count, sizeof(*devices));
+    for (int i = 0; i < count; i++) {
+        devices[i].config = bench_config(mode);
+        packet_queue_init(&devices[i].queue);
+        motion_pipeline_init(&devices[i].pipeline, &devices[i].config);
+        devices[i].uinput.fd = fd;
+        devices[i].uinput.initialized = true;
+        devices[i].time_us = 1000000;
+    }
+
+    // Notifications from all controllers interleave on the one loop
+    unsigned int frames = BENCH_SECONDS * SAMPLE_RATE_HZ / SAMPLES_PER_FRAME;
+    uint64_t samples = 0;
+    uint64_t start = process_cpu_ns();
+    for (unsigned int frame = 0; frame < frames; frame++) {
+        for (int i = 0; i < count; i++) {
+            receive_frame(&devices[i], i, monotonic_ns());
+            samples += drain(&devices[i]);
+        }
+    }
+    uint64_t elapsed = process_cpu_ns() - start;
+
+    uint32_t dropped = 0;
+    for (int i = 0; i < count; i++) dropped += devices[i].queue.dropped;
+    CHECK(dropped == 0);
+    CHECK(samples == (uint64_t)count * frames * SAMPLES_PER_FRAME);
+
+    double per_sample_ns = (double)elapsed / samples;
+    printf("  %-8s  %3d   %8.0f ns   %8.0f ns   %6.2f%%\n", mode_name, count, per_sample_ns,
+           per_sample_ns * SAMPLES_PER_FRAME, (double)elapsed / (BENCH_SECONDS * 1e9) * 100.0);
+    free(devices);
+}
+
+int main() {
+    int fd = open("/dev/null", O_WRONLY);
+    if (fd < 0) {
+        perror("/dev/null");
+        return 1;
+    }
+
+    printf("devices bench: %d s of %d Hz samples, %d per notification, per controller\n", BENCH_SECONDS,
+           SAMPLE_RATE_HZ, SAMPLES_PER_FRAME);
+    printf("  mode      devices  CPU/sample   CPU/notify   of one core\n");
+    for (unsigned int m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        for (unsigned int c = 0; c < sizeof(device_counts) / sizeof(device_counts[0]); c++) {
+            bench_devices(fd, modes[m], mode_names[m], device_counts[c]);
+        }
+    }
+
+    close(fd);
+    return check_report("devices bench");
+}
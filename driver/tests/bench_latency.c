@@ -0,0 +1,181 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "check.h"
+#include "event_loop.h"
+#include "timing.h"
+
+#define BENCH_SECONDS   3
+#define STREAM_RATE_HZ  200        // Firmware notification rate
+#define POLL_PERIOD_US  20000      // The 50 Hz loop the reactor replaced
+
+// One notification: stamped when it reaches the socket, padded to the
+// size of a bare SensorPacket
+typedef struct {
+    uint64_t sent_ns;
+    uint8_t padding[8];
+} Notification;
+
+typedef struct {
+    int fd;
+    unsigned int sent;
+} Producer;
+
+// The controller: a notification every 5 ms on an absolute schedule, so a
+// late consumer cannot slow the stream down
+static void* produce(void* user_data) {
+    Producer* producer = user_data;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    for (unsigned int i = 0; i < STREAM_RATE_HZ * BENCH_SECONDS; i++) {
+        next.tv_nsec += 1000000000L / STREAM_RATE_HZ;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        Notification notification;
+        memset(&notification, 0, sizeof(notification));
+        notification.sent_ns = monotonic_ns();
+        if (write(producer->fd, &notification, sizeof(notification)) == sizeof(notification)) producer->sent++;
+    }
+    return NULL;
+}
+
+typedef struct {
+    int fds[2];
+    Producer producer;
+    pthread_t thread;
+    LatencyHistogram latency;  // Socket arrival to processing
+    unsigned int processed;
+    unsigned int overwritten;  // Replaced in the single slot before anyone read them
+} Stream;
+
+static int stream_start(Stream* stream) {
+    memset(stream, 0, sizeof(*stream));
+    latency_histogram_reset(&stream->latency);
+    // Room for the whole run, so a slow reader never blocks the producer
+    int buffer = STREAM_RATE_HZ * BENCH_SECONDS * 1024;
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, stream->fds) < 0) return -1;
+    setsockopt(stream->fds[1], SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+    fcntl(stream->fds[0], F_SETFL, fcntl(stream->fds[0], F_GETFL) | O_NONBLOCK);
+
+    stream->producer.fd = stream->fds[1];
+    return pthread_create(&stream->thread, NULL, produce, &stream->producer) == 0 ? 0 : -1;
+}
+
+static void stream_stop(Stream* stream) {
+    pthread_join(stream->thread, NULL);
+    close(stream->fds[0]);
+    close(stream->fds[1]);
+}
+
+static bool stream_receive(Stream* stream, Notification* notification) {
+    return read(stream->fds[0], notification, sizeof(*notification)) == sizeof(*notification);
+}
+
+static void stream_process(Stream* stream, const Notification* notification) {
+    latency_histogram_record(&stream->latency, monotonic_ns() - notification->sent_ns);
+    stream->processed++;
+}
+
+// (a) The daemon's path: epoll wakes the loop when the socket turns
+// readable and every queued notification is handled straight away
+static void socket_ready(int fd, uint32_t events, void* user_data) {
+    (void)fd;
+    (void)events;
+    Stream* stream = user_data;
+    Notification notification;
+    while (stream_receive(stream, &notification)) stream_process(stream, &notification);
+}
+
+static int run_reactor(Stream* stream) {
+    EventLoop loop;
+    if (event_loop_init(&loop) < 0 || stream_start(stream) < 0) return -1;
+    if (event_loop_add(&loop, stream->fds[0], EPOLLIN, socket_ready, stream) < 0) return -1;
+
+    uint64_t end_ns = monotonic_ns() + (BENCH_SECONDS + 1) * 1000000000ULL;
+    while (stream->processed < STREAM_RATE_HZ * BENCH_SECONDS && monotonic_ns() < end_ns) {
+        if (event_loop_run_once(&loop, 100) < 0) break;
+    }
+
+    event_loop_cleanup(&loop);
+    stream_stop(stream);
+    return 0;
+}
+
+// (b) The old loop: each pass reads what has arrived into one packet slot,
+// handles the slot and sleeps 20 ms. Reading everything per pass is the
+// generous case; newer notifications overwrite unread ones.
+// (c) What the old loop actually did: dbus_connection_read_write_dispatch()
+// dispatches one message per call, so each pass handles only the oldest
+// notification and the rest queue up behind it.
+static int run_poll(Stream* stream, bool one_per_pass) {
+    if (stream_start(stream) < 0) return -1;
+
+    uint64_t end_ns = monotonic_ns() + (BENCH_SECONDS + 1) * 1000000000ULL;
+    while (monotonic_ns() < end_ns) {
+        Notification slot;
+        bool ready = false;
+        Notification notification;
+        while (stream_receive(stream, &notification)) {
+            if (ready) stream->overwritten++;
+            slot = notification;
+            ready = true;
+            if (one_per_pass) break;
+        }
+        if (ready) stream_process(stream, &slot);
+        usleep(POLL_PERIOD_US);
+    }
+
+    stream_stop(stream);
+    return 0;
+}
+
+static void print_percentile(const LatencyHistogram* hist, double percentile) {
+    double ms = latency_histogram_percentile_ms(hist, percentile);
+    if (ms > LATENCY_BUCKETS * LATENCY_BUCKET_US / 1000.0) {
+        printf("   >%5.0f ms", LATENCY_BUCKETS * LATENCY_BUCKET_US / 1000.0);
+    } else {
+        printf("  %7.2f ms", ms);
+    }
+}
+
+static void print_stream(const char* label, const Stream* stream) {
+    printf("  %-24s %5u/%-5u %5u", label, stream->processed, stream->producer.sent,
+           stream->producer.sent - stream->processed);
+    print_percentile(&stream->latency, 50.0);
+    print_percentile(&stream->latency, 99.0);
+    printf("  %8.2f ms\n", stream->latency.max_ns / 1e6);
+}
+
+int main() {
+    static Stream reactor, poll_latest, poll_oldest;
+
+    CHECK(run_reactor(&reactor) == 0);
+    CHECK(run_poll(&poll_latest, false) == 0);
+    CHECK(run_poll(&poll_oldest, true) == 0);
+
+    printf("latency bench: %d Hz synthetic stream for %d s, arrival to processing\n", STREAM_RATE_HZ,
+           BENCH_SECONDS);
+    printf("  loop                     handled      lost     median        p99         max\n");
+    print_stream("epoll reactor", &reactor);
+    print_stream("20 ms poll, latest slot", &poll_latest);
+    print_stream("20 ms poll, one per pass", &poll_oldest);
+
+    // The reactor handles every notification; the poll loop either loses
+    // most of them or falls further behind with every pass
+    CHECK(reactor.processed == reactor.producer.sent);
+    CHECK(poll_latest.processed + poll_latest.overwritten == poll_latest.producer.sent);
+    CHECK(poll_latest.overwritten > 0);
+    CHECK(poll_oldest.processed < poll_oldest.producer.sent);
+    CHECK(latency_histogram_percentile_ms(&reactor.latency, 50.0) <
+          latency_histogram_percentile_ms(&poll_oldest.latency, 50.0));
+    return check_report("latency bench");
+}
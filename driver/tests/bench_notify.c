@@ -0,0 +1,143 @@
+// The receive paths are internal to bluetooth.c, so the bench compiles that
+// file in directly
+#include "../src/bluetooth.c"
+#include <sys/socket.h>
+#include "check.h"
+#include "synthetic_frames.h"
+
+#define BENCH_NOTIFICATIONS 50000 // Each written, then received in its own wakeup as at 200 Hz
+#define CHAR_PATH   "/org/bluez/hci0/dev_00_11_22_33_44_55/service0010/char0011"
+#define DEVICE_PATH "/org/bluez/hci0/dev_00_11_22_33_44_55"
+
+bool running = true;
+MouseConfig config;
+
+static void discard_samples(BLEConnection* conn, void* user_data) {
+    (void)user_data;
+    conn->queue.tail = conn->queue.head;
+}
+
+static void bench_connection(BLEConnection* conn) {
+    memset(conn, 0, sizeof(*conn));
+    snprintf(conn->device_path, sizeof(conn->device_path), "%s", DEVICE_PATH);
+    snprintf(conn->char_path, sizeof(conn->char_path), "%s", CHAR_PATH);
+    conn->connected = true;
+    conn->notify_fd = -1;
+    conn->on_samples = discard_samples;
+    packet_queue_init(&conn->queue);
+}
+
+// The wire form of the PropertiesChanged signal BlueZ emits per
+// notification without AcquireNotify
+static char* marshal_value_signal(const uint8_t* payload, size_t length, int* wire_length) {
+    DBusMessage* msg = dbus_message_new_signal(CHAR_PATH, "org.freedesktop.DBus.Properties", "PropertiesChanged");
+    DBusMessageIter iter, changed, entry, variant, array, invalidated;
+    const char* interface = "org.bluez.GattCharacteristic1";
+    const char* property = "Value";
+
+    dbus_message_iter_init_append(msg, &iter);
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &interface);
+    dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{sv}", &changed);
+    dbus_message_iter_open_container(&changed, DBUS_TYPE_DICT_ENTRY, NULL, &entry);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &property);
+    dbus_message_iter_open_container(&entry, DBUS_TYPE_VARIANT, "ay", &variant);
+    dbus_message_iter_open_container(&variant, DBUS_TYPE_ARRAY, "y", &array);
+    dbus_message_iter_append_fixed_array(&array, DBUS_TYPE_BYTE, &payload, (int)length);
+    dbus_message_iter_close_container(&variant, &array);
+    dbus_message_iter_close_container(&entry, &variant);
+    dbus_message_iter_close_container(&changed, &entry);
+    dbus_message_iter_close_container(&iter, &changed);
+    dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "s", &invalidated);
+    dbus_message_iter_close_container(&iter, &invalidated);
+    dbus_message_set_serial(msg, 1);
+
+    char* wire = NULL;
+    dbus_message_marshal(msg, &wire, wire_length);
+    dbus_message_unref(msg);
+    return wire;
+}
+
+// PropertiesChanged: every notification is read off the bus socket, parsed
+// into a DBusMessage and walked by notification_handler(). The hop through
+// dbus-daemon costs another process on top and is not counted here.
+static double time_properties_changed(const uint8_t* payload, size_t length, unsigned int samples) {
+    int wire_length = 0;
+    char* wire = marshal_value_signal(payload, length, &wire_length);
+    int fds[2];
+    if (!wire || socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        CHECK(false);
+        return 0.0;
+    }
+
+    BLEConnection conn;
+    bench_connection(&conn);
+    char buffer[4096];
+    uint64_t elapsed = 0;
+    for (int i = 0; i < BENCH_NOTIFICATIONS; i++) {
+        CHECK(write(fds[1], wire, wire_length) == wire_length);
+
+        uint64_t start = process_cpu_ns();
+        if (read(fds[0], buffer, sizeof(buffer)) == wire_length) {
+            DBusMessage* msg = dbus_message_demarshal(buffer, wire_length, NULL);
+            if (msg) {
+                notification_handler(NULL, msg, &conn);
+                dbus_message_unref(msg);
+            }
+        }
+        elapsed += process_cpu_ns() - start;
+    }
+
+    CHECK(conn.samples == (uint32_t)BENCH_NOTIFICATIONS * samples);
+    close(fds[0]);
+    close(fds[1]);
+    dbus_free(wire);
+    return (double)elapsed / BENCH_NOTIFICATIONS;
+}
+
+// AcquireNotify: notify_fd_ready() reads the raw payload from the SEQPACKET
+// socket, decodes it from the stack and reads again until EAGAIN
+static double time_acquire_notify(const uint8_t* payload, size_t length, unsigned int samples) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) < 0) {
+        CHECK(false);
+        return 0.0;
+    }
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    BLEConnection conn;
+    bench_connection(&conn);
+    conn.notify_fd = fds[0];
+    uint64_t elapsed = 0;
+    for (int i = 0; i < BENCH_NOTIFICATIONS; i++) {
+        CHECK(write(fds[1], payload, length) == (ssize_t)length);
+
+        uint64_t start = process_cpu_ns();
+        notify_fd_ready(fds[0], EPOLLIN, &conn);
+        elapsed += process_cpu_ns() - start;
+    }
+
+    CHECK(conn.connected);
+    CHECK(conn.samples == (uint32_t)BENCH_NOTIFICATIONS * samples);
+    close(fds[0]);
+    close(fds[1]);
+    return (double)elapsed / BENCH_NOTIFICATIONS;
+}
+
+static void bench_payload(const char* name, const uint8_t* payload, size_t length, unsigned int samples) {
+    double bus = time_properties_changed(payload, length, samples);
+    double socket = time_acquire_notify(payload, length, samples);
+    double per_second = 200.0 / samples; // Notifications per second at 200 Hz
+    printf("  %-12s %4zu B  %7.0f ns  %7.0f ns  %5.2fx   %6.3f%%  %6.3f%%\n", name, length, bus, socket,
+           bus / socket, bus * per_second / 1e7, socket * per_second / 1e7);
+}
+
+int main() {
+    uint8_t payload[SENSOR_NOTIFY_MAX_LEN];
+
+    printf("notify bench: daemon CPU per notification, %d notifications per transport\n", BENCH_NOTIFICATIONS);
+    printf("  payload      bytes   PropsChg    AcqNotify  ratio   core at 200 Hz (PropsChg, AcqNotify)\n");
+    bench_payload("bare packet", payload, synthetic_bare_packet(payload, 0), 1);
+    bench_payload("v3 frame", payload, synthetic_v3_frame(payload, 0, 4), 4);
+    bench_payload("v5 frame", payload, synthetic_v5_frame(payload, 0, 4), 4);
+    return check_report("notify bench");
+}
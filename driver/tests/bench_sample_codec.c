@@ -0,0 +1,165 @@
+#define _GNU_SOURCE
+#include "sample_codec.h"
+#include <string.h>
+#include "check.h"
+#include "common.h"
+#include "timing.h"
+
+#define STREAM_SAMPLES   20000 // 100 s at 200 Hz
+#define SAMPLE_PERIOD_US 5000
+#define ACCEL_RANGE_G    8     // The firmware's MPU6886 settings
+#define GYRO_RANGE_DPS   2000
+#define FRAME_BUFFER     (16 + 30 * 16) // Firmware frameBuffer: v3 prefix plus 30 SensorPackets
+#define DELTA_PREFIX     (sizeof(SensorFrameHeader) + sizeof(ButtonEventHistory) + sizeof(DeltaFrameInfo))
+#define V3_PREFIX        (sizeof(SensorFrameHeader) + sizeof(ButtonEventHistory))
+#define DECODE_ROUNDS    50
+
+static const unsigned int mtus[] = {23, 64, 185, 247, 512};
+
+static uint32_t random_state = 0x2545F491;
+
+// xorshift32: reproducible across runs and platforms
+static uint32_t next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static int16_t walk(int16_t value, int step, int limit) {
+    int next = value + (int)(next_random() % (2 * step + 1)) - step;
+    if (next > limit) next = limit;
+    if (next < -limit) next = -limit;
+    return (int16_t)next;
+}
+
+// Hand-held motion in sensor LSBs: gravity on Z with a few hundred mg of
+// wobble, rotation wandering within +-250 deg/s, timestamps with scheduling
+// jitter
+static CodecSample stream[STREAM_SAMPLES];
+
+static void build_stream() {
+    int16_t one_g = 32768 / ACCEL_RANGE_G;
+    int16_t gyro_limit = (int16_t)(250 * 32768 / GYRO_RANGE_DPS);
+    CodecSample sample = {.accel = {0, 0, one_g}, .gyro = {0, 0, 0}, .timestamp_us = 1000000};
+
+    for (unsigned int i = 0; i < STREAM_SAMPLES; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            sample.accel[axis] = walk(sample.accel[axis], 40, 3 * one_g);
+            sample.gyro[axis] = walk(sample.gyro[axis], 60, gyro_limit);
+        }
+        sample.timestamp_us += SAMPLE_PERIOD_US - 100 + next_random() % 201;
+        stream[i] = sample;
+    }
+}
+
+typedef struct {
+    unsigned int notifications;
+    unsigned int samples;
+    uint64_t bytes;
+} Bandwidth;
+
+// Samples per version 3 frame under this MTU and batch size, as the
+// firmware's frameCapacity(); 1 or less means bare packets
+static int v3_capacity(unsigned int mtu, int batch) {
+    int fit = ((int)mtu - 3 - (int)V3_PREFIX) / (int)sizeof(SensorPacket);
+    if (fit > batch) fit = batch;
+    if (fit > 30) fit = 30;
+    return fit > 0 ? fit : 0;
+}
+
+// Frames the stream the way the firmware's sendSensorData() does: a frame
+// is sent once it holds batch samples, runs out of guaranteed room (version
+// 5) or its first sample is deadline_us old
+static Bandwidth frame_stream(unsigned int mtu, int batch, uint32_t deadline_us, bool delta) {
+    Bandwidth result = {0, 0, 0};
+    int capacity = v3_capacity(mtu, batch);
+    if (capacity <= 1) {
+        result.notifications = result.samples = STREAM_SAMPLES;
+        result.bytes = (uint64_t)STREAM_SAMPLES * sizeof(SensorPacket);
+        return result;
+    }
+
+    size_t payload = mtu - 3 < FRAME_BUFFER ? mtu - 3 : FRAME_BUFFER;
+    size_t budget = payload > DELTA_PREFIX ? payload - DELTA_PREFIX : 0;
+    int max_samples = batch < 30 ? batch : 30;
+    uint8_t buffer[FRAME_BUFFER];
+    SampleEncoder encoder;
+    unsigned int count = 0;
+    uint32_t start = 0;
+
+    for (unsigned int i = 0; i < STREAM_SAMPLES; i++) {
+        const CodecSample* sample = &stream[i];
+        if (count == 0) {
+            start = sample->timestamp_us;
+            if (delta) sample_encoder_init(&encoder, buffer, budget, start);
+        }
+        if (delta && !sample_encoder_add(&encoder, sample)) {
+            result.notifications++;
+            result.bytes += DELTA_PREFIX + encoder.length;
+            start = sample->timestamp_us;
+            sample_encoder_init(&encoder, buffer, budget, start);
+            CHECK(sample_encoder_add(&encoder, sample));
+            count = 0;
+        }
+        count++;
+        result.samples++;
+
+        bool full = delta ? (int)count >= max_samples || !sample_encoder_has_room(&encoder) : (int)count >= capacity;
+        if (full || sample->timestamp_us - start >= deadline_us || i == STREAM_SAMPLES - 1) {
+            result.notifications++;
+            result.bytes += delta ? DELTA_PREFIX + encoder.length : V3_PREFIX + count * sizeof(SensorPacket);
+            count = 0;
+        }
+    }
+    return result;
+}
+
+static void report_bandwidth(const char* title, int batch, uint32_t deadline_us) {
+    printf("\n%s\n", title);
+    printf("  MTU   v3 samples/notify  v3 bytes/sample   v5 samples/notify  v5 bytes/sample   saved\n");
+    for (unsigned int m = 0; m < sizeof(mtus) / sizeof(mtus[0]); m++) {
+        Bandwidth v3 = frame_stream(mtus[m], batch, deadline_us, false);
+        Bandwidth v5 = frame_stream(mtus[m], batch, deadline_us, true);
+        CHECK(v3.samples == STREAM_SAMPLES && v5.samples == STREAM_SAMPLES);
+
+        double v3_bytes = (double)v3.bytes / v3.samples;
+        double v5_bytes = (double)v5.bytes / v5.samples;
+        printf("  %3u   %17.1f  %15.1f   %17.1f  %15.1f  %5.1f%%\n", mtus[m],
+               (double)v3.samples / v3.notifications, v3_bytes,
+               (double)v5.samples / v5.notifications, v5_bytes, (1.0 - v5_bytes / v3_bytes) * 100.0);
+    }
+}
+
+// Host-side cost of the version 5 decoder on the same stream
+static void report_decode() {
+    static uint8_t buffer[STREAM_SAMPLES * SAMPLE_CODEC_MAX_SAMPLE_SIZE];
+    SampleEncoder encoder;
+    sample_encoder_init(&encoder, buffer, sizeof(buffer), stream[0].timestamp_us);
+    for (unsigned int i = 0; i < STREAM_SAMPLES; i++) CHECK(sample_encoder_add(&encoder, &stream[i]));
+
+    uint64_t checksum = 0;
+    uint64_t start = process_cpu_ns();
+    for (int round = 0; round < DECODE_ROUNDS; round++) {
+        SampleDecoder decoder;
+        CodecSample sample;
+        sample_decoder_init(&decoder, buffer, encoder.length, stream[0].timestamp_us);
+        while (sample_decoder_next(&decoder, &sample)) checksum += (uint16_t)sample.gyro[0] + sample.timestamp_us;
+        CHECK(sample_decoder_done(&decoder));
+    }
+    uint64_t elapsed = process_cpu_ns() - start;
+
+    printf("\nDecode: %.1f ns per sample, %.2f bytes per sample unframed (checksum %llx)\n",
+           (double)elapsed / ((double)DECODE_ROUNDS * STREAM_SAMPLES), (double)encoder.length / STREAM_SAMPLES,
+           (unsigned long long)checksum);
+}
+
+int main() {
+    build_stream();
+    printf("sample_codec bench: %u samples at %u Hz, +-%d g, +-%d deg/s\n", STREAM_SAMPLES,
+           1000000 / SAMPLE_PERIOD_US, ACCEL_RANGE_G, GYRO_RANGE_DPS);
+    report_bandwidth("Firmware defaults (SENSOR_BATCH_SIZE=4, SENSOR_FLUSH_DEADLINE_MS=10)", 4, 10000);
+    report_bandwidth("MTU bound (largest batch, no deadline)", 30, UINT32_MAX);
+    report_decode();
+    return check_report("sample_codec bench");
+}
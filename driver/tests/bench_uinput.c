@@ -0,0 +1,91 @@
+#define _GNU_SOURCE
+#include "uinput.h"
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include "check.h"
+#include "timing.h"
+
+#define BENCH_SECONDS 10
+
+static const unsigned int rates_hz[] = {200, 1000};
+
+// Representative output of one second of use, by position in the second:
+// mostly pointer motion, a still stretch, a tilt-scroll stretch with a
+// legacy detent now and then, and one click
+static void build_report(unsigned int i, unsigned int rate, MotionReport* report) {
+    memset(report, 0, sizeof(*report));
+    unsigned int phase = i % rate;
+    unsigned int percent = phase * 100 / rate;
+
+    if (phase == rate / 4) {
+        report->buttons[0].pressed = MOTION_BUTTON_LEFT;
+        report->button_count = 1;
+    } else if (phase == rate / 4 + rate / 10) {
+        report->buttons[0].released = MOTION_BUTTON_LEFT;
+        report->button_count = 1;
+    }
+
+    if (percent < 60) {
+        report->dx = 1 + (int)(i % 5);
+        report->dy = (int)(i % 3) - 1;
+    } else if (percent >= 75 && percent < 95) {
+        report->scroll.wheel_hi_res = -12;
+        if (phase % 10 == 0) report->scroll.wheel = -1;
+    }
+}
+
+// Before the frames were coalesced every event was its own write()
+static uint32_t per_event_writes(const MotionReport* report) {
+    uint32_t events = 0;
+    for (unsigned int i = 0; i < report->button_count; i++) {
+        if (report->buttons[i].released) events += 2;
+        if (report->buttons[i].pressed) events += 2;
+    }
+    unsigned int motion = (report->dx != 0) + (report->dy != 0) + (report->scroll.wheel_hi_res != 0) +
+                          (report->scroll.wheel != 0) + (report->scroll.hwheel_hi_res != 0) +
+                          (report->scroll.hwheel != 0) + (report->has_position ? 2 : 0);
+    return events + (motion ? motion + 1 : 0);
+}
+
+// A counting stub in place of /dev/uinput: emit_motion_report's own
+// counters see every write(), /dev/null swallows the bytes
+static void bench_rate(int fd, unsigned int rate) {
+    UInputDevice device;
+    memset(&device, 0, sizeof(device));
+    device.fd = fd;
+    device.initialized = true;
+
+    unsigned int reports = rate * BENCH_SECONDS;
+    uint64_t before = 0;
+    uint64_t start = process_cpu_ns();
+    for (unsigned int i = 0; i < reports; i++) {
+        MotionReport report;
+        build_report(i, rate, &report);
+        before += per_event_writes(&report);
+        emit_motion_report(&device, &report);
+    }
+    uint64_t elapsed = process_cpu_ns() - start;
+
+    CHECK(device.stats.failed == 0);
+    CHECK(device.stats.events == before);
+    printf("  %4u Hz   %8.1f   %8.1f   %6.2f   %5.1f   %6.0f ns\n", rate, (double)before / BENCH_SECONDS,
+           (double)device.stats.writes / BENCH_SECONDS, (double)device.stats.writes / reports,
+           (double)device.stats.events / device.stats.writes, (double)elapsed / reports);
+}
+
+int main() {
+    int fd = open("/dev/null", O_WRONLY);
+    if (fd < 0) {
+        perror("/dev/null");
+        return 1;
+    }
+
+    printf("uinput bench: write() calls for a motion/still/scroll/click mix over %d s\n", BENCH_SECONDS);
+    printf("  rate      per-event   per-frame  writes/   events/  CPU per\n");
+    printf("            writes/s    writes/s   report    write    report\n");
+    for (unsigned int r = 0; r < sizeof(rates_hz) / sizeof(rates_hz[0]); r++) bench_rate(fd, rates_hz[r]);
+
+    close(fd);
+    return check_report("uinput bench");
+}
@@ -0,0 +1,27 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// Minimal assertions for the host tests: a failed check is reported and
+// counted, the test carries on, and check_report() turns the count into
+// the exit status
+static int check_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        check_failures++; \
+    } \
+} while (0)
+
+static inline int check_report(const char* name) {
+    if (check_failures) {
+        fprintf(stderr, "%s: %d check%s failed\n", name, check_failures, check_failures == 1 ? "" : "s");
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef SYNTHETIC_FRAMES_H
+#define SYNTHETIC_FRAMES_H
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include "common.h"
+#include "sample_codec.h"
+
+// Notification payloads as the firmware sends them, for the benchmarks that
+// feed the driver's receive path. Readings follow a slow sweep so version 5
+// deltas stay as small as real motion makes them.
+
+#define SYNTHETIC_PERIOD_US 5000 // 200 Hz
+
+static inline void synthetic_reading(unsigned int index, int16_t accel[3], int16_t gyro[3]) {
+    float t = index * (SYNTHETIC_PERIOD_US / 1e6f);
+    accel[0] = (int16_t)(1200.0f * sinf(t * 1.1f));
+    accel[1] = (int16_t)(800.0f * sinf(t * 0.7f + 1.0f));
+    accel[2] = (int16_t)(3900.0f + 200.0f * cosf(t * 1.3f));
+    gyro[0] = (int16_t)(330.0f * sinf(t * 2.0f));
+    gyro[1] = (int16_t)(570.0f * cosf(t * 1.5f));
+    gyro[2] = (int16_t)(820.0f * sinf(t * 0.9f + 0.5f));
+}
+
+// A bare SensorPacket, what firmware at the default MTU sends. Returns the
+// payload length.
+static inline size_t synthetic_bare_packet(uint8_t* buffer, unsigned int index) {
+    SensorPacket packet;
+    int16_t accel[3], gyro[3];
+    synthetic_reading(index, accel, gyro);
+    packet.accel_x = accel[0] / 41; // LSB at +-8 g to g * 100
+    packet.accel_y = accel[1] / 41;
+    packet.accel_z = accel[2] / 41;
+    packet.gyro_x = gyro[0] * 10 / 16; // LSB at +-2000 deg/s to deg/s * 10
+    packet.gyro_y = gyro[1] * 10 / 16;
+    packet.gyro_z = gyro[2] * 10 / 16;
+    packet.button_state = 0;
+    packet.button_sequence = 0;
+    packet.timestamp = (uint16_t)(index * SYNTHETIC_PERIOD_US / 1000);
+    memcpy(buffer, &packet, sizeof(packet));
+    return sizeof(packet);
+}
+
+static inline size_t synthetic_frame_prefix(uint8_t* buffer, uint8_t version, unsigned int first,
+                                            unsigned int count) {
+    SensorFrameHeader header;
+    header.version = version;
+    header.count = (uint8_t)count;
+    header.sequence = (uint16_t)(first / (count ? count : 1));
+    header.timestamp = first * SYNTHETIC_PERIOD_US;
+    memcpy(buffer, &header, sizeof(header));
+
+    ButtonEventHistory history;
+    memset(&history, 0, sizeof(history));
+    memcpy(buffer + sizeof(header), &history, sizeof(history));
+    return sizeof(header) + sizeof(history);
+}
+
+// A version 3 frame of count SensorPackets starting at sample first
+static inline size_t synthetic_v3_frame(uint8_t* buffer, unsigned int first, unsigned int count) {
+    size_t length = synthetic_frame_prefix(buffer, SENSOR_FRAME_VERSION, first, count);
+    for (unsigned int i = 0; i < count; i++) {
+        SensorPacket packet;
+        synthetic_bare_packet((uint8_t*)&packet, first + i);
+        packet.timestamp = (uint16_t)((first + i) * SYNTHETIC_PERIOD_US);
+        memcpy(buffer + length, &packet, sizeof(packet));
+        length += sizeof(packet);
+    }
+    return length;
+}
+
+// A version 5 frame of count delta/varint coded samples starting at sample
+// first; buffer must hold SENSOR_NOTIFY_MAX_LEN bytes
+static inline size_t synthetic_v5_frame(uint8_t* buffer, unsigned int first, unsigned int count) {
+    size_t length = synthetic_frame_prefix(buffer, SENSOR_FRAME_VERSION_DELTA, first, count);
+
+    DeltaFrameInfo info;
+    info.button_state = 0;
+    info.button_sequence = 0;
+    info.block.encoding = SAMPLE_CODEC_DELTA_VARINT;
+    info.block.accel_range_g = 8;
+    info.block.gyro_range_dps = 2000;
+    memcpy(buffer + length, &info, sizeof(info));
+    length += sizeof(info);
+
+    SampleEncoder encoder;
+    sample_encoder_init(&encoder, buffer + length, SENSOR_NOTIFY_MAX_LEN - length, first * SYNTHETIC_PERIOD_US);
+    for (unsigned int i = 0; i < count; i++) {
+        CodecSample sample;
+        synthetic_reading(first + i, sample.accel, sample.gyro);
+        sample.timestamp_us = (first + i) * SYNTHETIC_PERIOD_US;
+        if (!sample_encoder_add(&encoder, &sample)) break;
+    }
+    buffer[offsetof(SensorFrameHeader, count)] = (uint8_t)encoder.count;
+    return length + encoder.length;
+}
+
+#endif
@@ -0,0 +1,141 @@
+#define _GNU_SOURCE
+#include "motion_filter.h"
+#include <math.h>
+#include <string.h>
+#include "check.h"
+
+#define TRACE_RATE_HZ  200
+#define TRACE_SAMPLES  (TRACE_RATE_HZ * 6)
+#define TRACE_NOISE    8.0f   // px/s, roughly the jitter of a hand-held controller
+
+static uint32_t random_state = 0x9E3779B9;
+
+// xorshift32: reproducible across runs and platforms
+static uint32_t next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+// Approximately normal, unit variance: sum of twelve uniforms
+static float next_noise() {
+    float sum = 0.0f;
+    for (int i = 0; i < 12; i++) sum += (next_random() >> 8) / 16777216.0f;
+    return sum - 6.0f;
+}
+
+// Cursor velocity (px/s) of a recorded-style gesture: rest, a sweep right
+// that slows down, a short flick up-left and rest again
+static void trace_velocity(int i, float* x, float* y) {
+    float t = (float)i / TRACE_RATE_HZ;
+    *x = 0.0f;
+    *y = 0.0f;
+    if (t >= 0.5f && t < 1.5f) {
+        *x = 600.0f * (t - 0.5f);
+    } else if (t >= 1.5f && t < 3.5f) {
+        *x = 600.0f - 300.0f * (t - 1.5f);
+    } else if (t >= 4.0f && t < 4.5f) {
+        *x = -800.0f * (t - 4.0f);
+        *y = -400.0f * (t - 4.0f);
+    }
+}
+
+static float trace_x[TRACE_SAMPLES], trace_y[TRACE_SAMPLES];
+
+static void build_trace() {
+    for (int i = 0; i < TRACE_SAMPLES; i++) {
+        trace_velocity(i, &trace_x[i], &trace_y[i]);
+        trace_x[i] += next_noise() * TRACE_NOISE;
+        trace_y[i] += next_noise() * TRACE_NOISE;
+    }
+}
+
+static MouseConfig filter_config(MotionFilterType type) {
+    MouseConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.motion_filter = type;
+    cfg.filter_min_cutoff = 1.0f; // The daemon's defaults
+    cfg.filter_beta = 0.02f;
+    cfg.filter_d_cutoff = 1.0f;
+    cfg.filter_process_noise = 5000.0f;
+    cfg.filter_measurement_noise = 25.0f;
+    return cfg;
+}
+
+// Replays the trace and returns the jitter reduction and added latency the
+// filter measured on it
+static bool replay(MotionFilterType type, double* jitter_reduction, double* latency_ms) {
+    MouseConfig cfg = filter_config(type);
+    MotionFilter filter;
+    motion_filter_init(&filter, &cfg);
+
+    float dt = 1.0f / TRACE_RATE_HZ;
+    for (int i = 0; i < TRACE_SAMPLES; i++) {
+        float x = trace_x[i], y = trace_y[i];
+        motion_filter_apply(&filter, &x, &y, dt);
+        CHECK(isfinite(x) && isfinite(y));
+    }
+    bool measured = motion_filter_measure(&filter, jitter_reduction, latency_ms);
+    if (measured) {
+        printf("motion_filter: %-8s jitter reduced %.1f%%, added latency %.1f ms\n", motion_filter_name(type),
+               *jitter_reduction * 100.0, *latency_ms);
+    }
+    return measured;
+}
+
+static void test_bypass() {
+    MouseConfig cfg = filter_config(MOTION_FILTER_NONE);
+    MotionFilter filter;
+    motion_filter_init(&filter, &cfg);
+
+    float x = trace_x[0], y = trace_y[0];
+    motion_filter_apply(&filter, &x, &y, 1.0f / TRACE_RATE_HZ);
+    CHECK(x == trace_x[0] && y == trace_y[0]);
+
+    double jitter_reduction, latency_ms;
+    CHECK(!motion_filter_measure(&filter, &jitter_reduction, &latency_ms));
+}
+
+// Both filters must remove most of the jitter and add less lag than one
+// frame at 60 Hz. At the defaults Kalman smooths harder and lags more.
+static void test_trace() {
+    double one_euro_jitter, one_euro_latency;
+    double kalman_jitter, kalman_latency;
+
+    CHECK(replay(MOTION_FILTER_ONE_EURO, &one_euro_jitter, &one_euro_latency));
+    CHECK(replay(MOTION_FILTER_KALMAN, &kalman_jitter, &kalman_latency));
+
+    CHECK(one_euro_jitter > 0.7);
+    CHECK(one_euro_latency > 0.0 && one_euro_latency < 10.0);
+    CHECK(kalman_jitter > 0.9);
+    CHECK(kalman_latency > 0.0 && kalman_latency < 16.7);
+    CHECK(kalman_jitter > one_euro_jitter && kalman_latency > one_euro_latency);
+}
+
+// A step settles to the new value instead of ringing or drifting
+static void test_step_settles() {
+    MotionFilterType types[] = {MOTION_FILTER_ONE_EURO, MOTION_FILTER_KALMAN};
+    for (unsigned int t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        MouseConfig cfg = filter_config(types[t]);
+        MotionFilter filter;
+        motion_filter_init(&filter, &cfg);
+
+        float x = 0.0f, y = 0.0f;
+        motion_filter_apply(&filter, &x, &y, 1.0f / TRACE_RATE_HZ);
+        for (int i = 0; i < TRACE_RATE_HZ * 2; i++) {
+            x = 300.0f;
+            y = -300.0f;
+            motion_filter_apply(&filter, &x, &y, 1.0f / TRACE_RATE_HZ);
+        }
+        CHECK(fabsf(x - 300.0f) < 1.0f && fabsf(y + 300.0f) < 1.0f);
+    }
+}
+
+int main() {
+    build_trace();
+    test_bypass();
+    test_trace();
+    test_step_settles();
+    return check_report("motion_filter");
+}
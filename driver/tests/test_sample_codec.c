@@ -0,0 +1,226 @@
+#define _GNU_SOURCE
+#include "sample_codec.h"
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+
+#define RANDOM_SAMPLES 4096
+
+static uint32_t random_state = 0x12345678;
+
+// xorshift32: reproducible across runs and platforms
+static uint32_t next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static bool same_sample(const CodecSample* a, const CodecSample* b) {
+    return memcmp(a->accel, b->accel, sizeof(a->accel)) == 0 && memcmp(a->gyro, b->gyro, sizeof(a->gyro)) == 0 &&
+           a->timestamp_us == b->timestamp_us;
+}
+
+// Encodes the samples into as many blocks as it takes, each restarted with
+// the sample that did not fit as its key frame the way the firmware does,
+// then decodes every block and compares
+static void check_round_trip(const CodecSample* samples, unsigned int count, size_t capacity) {
+    uint8_t* buffer = malloc(capacity);
+    unsigned int decoded = 0;
+    unsigned int i = 0;
+
+    while (i < count) {
+        SampleEncoder encoder;
+        uint32_t base = samples[i].timestamp_us;
+        sample_encoder_init(&encoder, buffer, capacity, base);
+        while (i < count && sample_encoder_add(&encoder, &samples[i])) i++;
+        CHECK(encoder.count > 0);
+        if (encoder.count == 0) break;
+
+        SampleDecoder decoder;
+        CodecSample sample;
+        sample_decoder_init(&decoder, buffer, encoder.length, base);
+        for (unsigned int n = 0; n < encoder.count; n++) {
+            CHECK(sample_decoder_next(&decoder, &sample));
+            CHECK(same_sample(&sample, &samples[decoded]));
+            decoded++;
+        }
+        CHECK(sample_decoder_done(&decoder));
+        CHECK(!sample_decoder_next(&decoder, &sample));
+    }
+    CHECK(decoded == count);
+    free(buffer);
+}
+
+static void test_random_deltas() {
+    static CodecSample samples[RANDOM_SAMPLES];
+    uint32_t timestamp = 0xFFFF0000; // Wraps partway through
+
+    for (unsigned int i = 0; i < RANDOM_SAMPLES; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            // Mostly small steps like real motion, now and then any value
+            if (next_random() % 8 == 0) {
+                samples[i].accel[axis] = (int16_t)next_random();
+                samples[i].gyro[axis] = (int16_t)next_random();
+            } else {
+                int16_t accel = i ? samples[i - 1].accel[axis] : 0;
+                int16_t gyro = i ? samples[i - 1].gyro[axis] : 0;
+                samples[i].accel[axis] = (int16_t)(accel + (int)(next_random() % 65) - 32);
+                samples[i].gyro[axis] = (int16_t)(gyro + (int)(next_random() % 513) - 256);
+            }
+        }
+        timestamp += 4000 + next_random() % 2000;
+        samples[i].timestamp_us = timestamp;
+    }
+
+    check_round_trip(samples, RANDOM_SAMPLES, 64 * 1024);
+    check_round_trip(samples, RANDOM_SAMPLES, 247 - 22); // One frame at a 250 byte MTU
+}
+
+// Every channel swings end to end and the clock jumps as far as it can
+static void test_extreme_deltas() {
+    CodecSample samples[8];
+    for (int i = 0; i < 8; i++) {
+        int16_t value = i % 2 ? INT16_MAX : INT16_MIN;
+        for (int axis = 0; axis < 3; axis++) {
+            samples[i].accel[axis] = value;
+            samples[i].gyro[axis] = (int16_t)(-value - 1);
+        }
+        samples[i].timestamp_us = i % 2 ? 0xFFFFFFFFu : 0;
+    }
+
+    uint8_t buffer[8 * SAMPLE_CODEC_MAX_SAMPLE_SIZE];
+    SampleEncoder encoder;
+    sample_encoder_init(&encoder, buffer, sizeof(buffer), 0);
+    for (int i = 0; i < 8; i++) CHECK(sample_encoder_add(&encoder, &samples[i]));
+    CHECK(encoder.length <= 8 * SAMPLE_CODEC_MAX_SAMPLE_SIZE);
+
+    check_round_trip(samples, 8, sizeof(buffer));
+    check_round_trip(samples, 8, SAMPLE_CODEC_MAX_SAMPLE_SIZE); // One sample per block
+}
+
+// A block cut short decodes its whole samples and is never done
+static void test_truncated_input() {
+    CodecSample samples[16];
+    for (int i = 0; i < 16; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            samples[i].accel[axis] = (int16_t)(i * 700 - axis * 3000);
+            samples[i].gyro[axis] = (int16_t)(axis * 9000 - i * 1300);
+        }
+        samples[i].timestamp_us = 1000000 + i * 5000;
+    }
+
+    uint8_t buffer[16 * SAMPLE_CODEC_MAX_SAMPLE_SIZE];
+    size_t ends[16];
+    SampleEncoder encoder;
+    sample_encoder_init(&encoder, buffer, sizeof(buffer), samples[0].timestamp_us);
+    for (int i = 0; i < 16; i++) {
+        CHECK(sample_encoder_add(&encoder, &samples[i]));
+        ends[i] = encoder.length;
+    }
+
+    for (size_t length = 0; length < encoder.length; length++) {
+        SampleDecoder decoder;
+        CodecSample sample;
+        sample_decoder_init(&decoder, buffer, length, samples[0].timestamp_us);
+
+        int whole = 0;
+        while (whole < 16 && ends[whole] <= length) whole++;
+        for (int i = 0; i < whole; i++) {
+            CHECK(sample_decoder_next(&decoder, &sample));
+            CHECK(same_sample(&sample, &samples[i]));
+        }
+        CHECK(!sample_decoder_next(&decoder, &sample));
+        CHECK(sample_decoder_done(&decoder) == (length == (whole ? ends[whole - 1] : 0)));
+    }
+}
+
+static bool decodes(const uint8_t* data, size_t length, CodecSample* sample) {
+    SampleDecoder decoder;
+    sample_decoder_init(&decoder, data, length, 0);
+    return sample_decoder_next(&decoder, sample) && sample_decoder_done(&decoder);
+}
+
+static void test_malformed_varints() {
+    CodecSample sample;
+
+    // Largest time step: the fifth byte carries only the top four bits
+    const uint8_t max_step[] = {0xFF, 0xFF, 0xFF, 0xFF, 0x0F, 0, 0, 0, 0, 0, 0};
+    CHECK(decodes(max_step, sizeof(max_step), &sample));
+    CHECK(sample.timestamp_us == 0xFFFFFFFFu);
+
+    // Bits beyond 32 are an error, not silently dropped
+    const uint8_t wide_step[] = {0xFF, 0xFF, 0xFF, 0xFF, 0x1F, 0, 0, 0, 0, 0, 0};
+    CHECK(!decodes(wide_step, sizeof(wide_step), &sample));
+    const uint8_t high_step[] = {0x80, 0x80, 0x80, 0x80, 0x70, 0, 0, 0, 0, 0, 0};
+    CHECK(!decodes(high_step, sizeof(high_step), &sample));
+
+    // A sixth byte never belongs to a 32-bit value
+    const uint8_t long_step[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0, 0, 0, 0, 0, 0};
+    CHECK(!decodes(long_step, sizeof(long_step), &sample));
+
+    // Channel deltas beyond two int16 readings apart
+    const uint8_t wide_delta[] = {0x00, 0x80, 0x80, 0x08, 0, 0, 0, 0, 0};
+    CHECK(!decodes(wide_delta, sizeof(wide_delta), &sample));
+
+    // A legal delta that walks out of the int16 range
+    const uint8_t overflow[] = {0x00, 0xFE, 0xFF, 0x03, 0, 0, 0, 0, 0};
+    CHECK(decodes(overflow, sizeof(overflow), &sample));
+    CHECK(sample.accel[0] == INT16_MAX);
+    SampleDecoder decoder;
+    uint8_t twice[2 * sizeof(overflow)];
+    memcpy(twice, overflow, sizeof(overflow));
+    memcpy(twice + sizeof(overflow), overflow, sizeof(overflow));
+    sample_decoder_init(&decoder, twice, sizeof(twice), 0);
+    CHECK(sample_decoder_next(&decoder, &sample));
+    CHECK(!sample_decoder_next(&decoder, &sample));
+    CHECK(!sample_decoder_done(&decoder));
+}
+
+// sample_encoder_add only accepts a sample it can promise room for, however
+// small the sample turns out to be
+static void test_budget_boundary() {
+    uint8_t buffer[2 * SAMPLE_CODEC_MAX_SAMPLE_SIZE];
+    CodecSample still;
+    memset(&still, 0, sizeof(still));
+    SampleEncoder encoder;
+
+    sample_encoder_init(&encoder, buffer, SAMPLE_CODEC_MAX_SAMPLE_SIZE - 1, 0);
+    CHECK(!sample_encoder_has_room(&encoder));
+    CHECK(!sample_encoder_add(&encoder, &still));
+    CHECK(encoder.length == 0 && encoder.count == 0);
+
+    sample_encoder_init(&encoder, buffer, SAMPLE_CODEC_MAX_SAMPLE_SIZE, 0);
+    CHECK(sample_encoder_add(&encoder, &still));
+    CHECK(encoder.length == 7);
+    CHECK(!sample_encoder_has_room(&encoder));
+    CHECK(!sample_encoder_add(&encoder, &still));
+    CHECK(encoder.count == 1 && encoder.length == 7);
+
+    // Room for exactly one worst case after the first sample
+    sample_encoder_init(&encoder, buffer, 7 + SAMPLE_CODEC_MAX_SAMPLE_SIZE, 0);
+    CHECK(sample_encoder_add(&encoder, &still));
+    CHECK(sample_encoder_has_room(&encoder));
+    CodecSample jump = still;
+    jump.accel[0] = INT16_MIN;
+    jump.gyro[2] = INT16_MAX;
+    jump.timestamp_us = 0xF0000000u;
+    CHECK(sample_encoder_add(&encoder, &jump));
+    CHECK(encoder.length <= encoder.capacity);
+
+    SampleDecoder decoder;
+    CodecSample sample;
+    sample_decoder_init(&decoder, buffer, encoder.length, 0);
+    CHECK(sample_decoder_next(&decoder, &sample) && same_sample(&sample, &still));
+    CHECK(sample_decoder_next(&decoder, &sample) && same_sample(&sample, &jump));
+    CHECK(sample_decoder_done(&decoder));
+}
+
+int main() {
+    test_random_deltas();
+    test_extreme_deltas();
+    test_truncated_input();
+    test_malformed_varints();
+    test_budget_boundary();
+    return check_report("sample_codec");
+}
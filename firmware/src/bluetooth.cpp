@@ -1,53 +1,242 @@
 #include "bluetooth.h"
 #include "sensor.h"
 #include <M5Atom.h>
+#include <math.h>
 
 void initBluetooth() {
     Serial.println("🔵 Bluetooth stack initialized!");
     Serial.println("📶 BLE ready for peripheral mode");
 }
 
+uint16_t peerMtu = 23;
+
+#define FRAME_PREFIX_SIZE (sizeof(SensorFrameHeader) + sizeof(ButtonEventHistory))
+#define DELTA_PREFIX_SIZE (FRAME_PREFIX_SIZE + sizeof(DeltaFrameInfo))
+// Coded samples are smaller, so the MTU no longer caps the count; the coded
+// bytes still have to fit
+#define DELTA_FRAME_MAX_SAMPLES (SENSOR_BATCH_SIZE < SENSOR_FRAME_MAX_SAMPLES ? SENSOR_BATCH_SIZE : SENSOR_FRAME_MAX_SAMPLES)
+
+static uint8_t frameBuffer[FRAME_PREFIX_SIZE + SENSOR_FRAME_MAX_SAMPLES * sizeof(SensorPacket)];
+static uint8_t frameCount = 0;
+static uint16_t frameSequence = 0;
+static uint32_t frameStartUs = 0;
+static uint8_t frameVersion = SENSOR_FRAME_VERSION;
+static SampleEncoder frameEncoder;   ///< Fills version 5 frames after DELTA_PREFIX_SIZE
+static uint8_t frameButtonState = 0; ///< Button state and sequence of every sample in a version 5 frame
+static uint8_t frameButtonSequence = 0;
+static uint8_t lastButtonState = 0;
+static uint8_t buttonSequence = 0;
+static ButtonEventHistory buttonHistory;
+
+/**
+ * Samples per notification allowed by the batch size and negotiated MTU
+ */
+static uint8_t frameCapacity() {
+    int payload = (int)peerMtu - 3 - (int)FRAME_PREFIX_SIZE;
+    int fit = payload / (int)sizeof(SensorPacket);
+    if (fit > SENSOR_BATCH_SIZE) fit = SENSOR_BATCH_SIZE;
+    if (fit > SENSOR_FRAME_MAX_SAMPLES) fit = SENSOR_FRAME_MAX_SAMPLES;
+    return fit > 0 ? fit : 0;
+}
+
+/**
+ * Coded bytes a version 5 frame may use under the negotiated MTU
+ */
+static size_t deltaFrameBudget() {
+    size_t payload = peerMtu > 3 ? peerMtu - 3 : 0;
+    if (payload > sizeof(frameBuffer)) payload = sizeof(frameBuffer);
+    return payload > DELTA_PREFIX_SIZE ? payload - DELTA_PREFIX_SIZE : 0;
+}
+
+/**
+ * Frame version a sample goes out in
+ */
+static uint8_t frameVersionFor(const ImuSample& sample) {
+#if SENSOR_PAYLOAD_FUSED
+    if (sample.fused) return SENSOR_FRAME_VERSION_FUSED;
+#else
+    (void)sample;
+#endif
+    return SENSOR_DELTA_FRAMES ? SENSOR_FRAME_VERSION_DELTA : SENSOR_FRAME_VERSION;
+}
+
+void flushSensorData() {
+    if (frameCount == 0 || !pCharacteristic) return;
+
+    SensorFrameHeader header;
+    header.version = frameVersion;
+    header.count = frameCount;
+    header.sequence = frameSequence++;
+    header.timestamp = frameStartUs;
+    memcpy(frameBuffer, &header, sizeof(header));
+    memcpy(frameBuffer + sizeof(header), &buttonHistory, sizeof(buttonHistory));
+
+    size_t length = FRAME_PREFIX_SIZE + frameCount * sizeof(SensorPacket);
+    if (frameVersion == SENSOR_FRAME_VERSION_DELTA) {
+        DeltaFrameInfo info;
+        info.button_state = frameButtonState;
+        info.button_sequence = frameButtonSequence;
+        info.block.encoding = SAMPLE_CODEC_DELTA_VARINT;
+        info.block.accel_range_g = SENSOR_ACCEL_RANGE_G;
+        info.block.gyro_range_dps = SENSOR_GYRO_RANGE_DPS;
+        memcpy(frameBuffer + FRAME_PREFIX_SIZE, &info, sizeof(info));
+        length = DELTA_PREFIX_SIZE + frameEncoder.length;
+    }
+
+    pCharacteristic->setValue(frameBuffer, length);
+    pCharacteristic->notify();
+    frameCount = 0;
+}
+
+/**
+ * Open a frame with this sample as its first, for version 5 the key frame
+ */
+static void startFrame(uint32_t now, uint8_t version, uint8_t buttonState) {
+    frameStartUs = now;
+    frameVersion = version;
+    frameButtonState = buttonState;
+    frameButtonSequence = buttonSequence;
+    if (version == SENSOR_FRAME_VERSION_DELTA) {
+        sample_encoder_init(&frameEncoder, frameBuffer + DELTA_PREFIX_SIZE, deltaFrameBudget(), now);
+    }
+}
+
+void resetSensorData() {
+    frameCount = 0;
+    frameSequence = 0;
+    lastButtonState = 0;
+    buttonSequence = 0;
+    memset(&buttonHistory, 0, sizeof(buttonHistory));
+}
+
+/**
+ * Numbers a button change and appends it to the history sent with every frame
+ */
+static void recordButtonChange(uint8_t buttonState) {
+    buttonSequence++;
+    memmove(&buttonHistory.events[0], &buttonHistory.events[1],
+            (BUTTON_EVENT_HISTORY - 1) * sizeof(ButtonEventRecord));
+    buttonHistory.events[BUTTON_EVENT_HISTORY - 1].sequence = buttonSequence;
+    buttonHistory.events[BUTTON_EVENT_HISTORY - 1].state = buttonState;
+}
+
+#if SENSOR_PAYLOAD_FUSED
+static int16_t quantize(float value, float scale) {
+    float scaled = roundf(value * scale);
+    if (scaled > 32767.0f) return 32767;
+    if (scaled < -32768.0f) return -32768;
+    return (int16_t)scaled;
+}
+
+/**
+ * Orientation and linear acceleration in place of the raw readings. q and -q
+ * are the same rotation, so the sign is chosen to make w non-negative and
+ * only x, y and z are sent.
+ */
+static void packFused(const ImuSample& sample, const SensorPacket& packet, FusedPacket* fused) {
+    float sign = sample.quat_w < 0.0f ? -1.0f : 1.0f;
+    fused->quat_x = quantize(sign * sample.quat_x, 32767.0f);
+    fused->quat_y = quantize(sign * sample.quat_y, 32767.0f);
+    fused->quat_z = quantize(sign * sample.quat_z, 32767.0f);
+    fused->linear_x = quantize(sample.linear_x, 1000.0f);
+    fused->linear_y = quantize(sample.linear_y, 1000.0f);
+    fused->linear_z = quantize(sample.linear_z, 1000.0f);
+    fused->button_state = packet.button_state;
+    fused->button_sequence = packet.button_sequence;
+    fused->timestamp = packet.timestamp;
+}
+#endif
+
 /**
  * Send sensor data packet over BLE
  * buttonState: 0 = no click, 1 = left click, 2 = right click
  */
-void sendSensorData(uint8_t buttonState) {
+void sendSensorData(const ImuSample& sample, uint8_t buttonState) {
     if (!deviceConnected || !pCharacteristic) return;
 
     SensorPacket packet;
-
-    // Get sensor readings as floats
-    float accel_x_f, accel_y_f, accel_z_f;
-    float gyro_x_f, gyro_y_f, gyro_z_f;
-    getSensorData(&accel_x_f, &accel_y_f, &accel_z_f,
-                  &gyro_x_f, &gyro_y_f, &gyro_z_f);
+    uint32_t now = sample.timestampUs;
 
     // Convert to scaled integers to fit in 20 bytes
-    packet.accel_x = (int16_t)(accel_x_f * 100.0f);
-    packet.accel_y = (int16_t)(accel_y_f * 100.0f);
-    packet.accel_z = (int16_t)(accel_z_f * 100.0f);
-    packet.gyro_x = (int16_t)(gyro_x_f * 10.0f);
-    packet.gyro_y = (int16_t)(gyro_y_f * 10.0f);
-    packet.gyro_z = (int16_t)(gyro_z_f * 10.0f);
+    packet.accel_x = (int16_t)(sample.accel_x * 100.0f);
+    packet.accel_y = (int16_t)(sample.accel_y * 100.0f);
+    packet.accel_z = (int16_t)(sample.accel_z * 100.0f);
+    packet.gyro_x = (int16_t)(sample.gyro_x * 10.0f);
+    packet.gyro_y = (int16_t)(sample.gyro_y * 10.0f);
+    packet.gyro_z = (int16_t)(sample.gyro_z * 10.0f);
 
+    bool buttonChanged = buttonState != lastButtonState;
+    if (buttonChanged) recordButtonChange(buttonState);
     packet.button_state = buttonState;
-    packet.padding = 0;
-    packet.timestamp = (uint16_t)(millis() & 0xFFFF);
+    packet.button_sequence = buttonSequence;
 
-    // Send via BLE
-    pCharacteristic->setValue((uint8_t*)&packet, sizeof(packet));
-    pCharacteristic->notify();
+    uint8_t capacity = frameCapacity();
+    if (capacity <= 1) {
+        // Default MTU or batching disabled: one bare packet per notification,
+        // which keeps the millisecond timestamp older drivers expect
+        packet.timestamp = (uint16_t)((now / 1000) & 0xFFFF);
+        pCharacteristic->setValue((uint8_t*)&packet, sizeof(packet));
+        pCharacteristic->notify();
+    } else {
+        // A frame may only span what the 16-bit sample offsets can express
+        // and carries one kind of payload. Version 5 frames also hold one
+        // button state, so a change starts a new frame.
+        uint8_t version = frameVersionFor(sample);
+        bool delta = version == SENSOR_FRAME_VERSION_DELTA;
+        if (frameCount > 0 && (now - frameStartUs > SENSOR_FRAME_MAX_SPAN_US || version != frameVersion ||
+                               (delta && buttonChanged))) {
+            flushSensorData();
+        }
+
+        if (frameCount == 0) startFrame(now, version, buttonState);
+        packet.timestamp = (uint16_t)(now & 0xFFFF);
+        uint8_t* slot = frameBuffer + FRAME_PREFIX_SIZE + frameCount * sizeof(SensorPacket);
+        bool stored = true;
+        if (delta) {
+            CodecSample coded;
+            memcpy(coded.accel, sample.accel_lsb, sizeof(coded.accel));
+            memcpy(coded.gyro, sample.gyro_lsb, sizeof(coded.gyro));
+            coded.timestamp_us = now;
+            if (!sample_encoder_add(&frameEncoder, &coded)) {
+                // No guaranteed room left: send what is coded and make this
+                // sample the key frame of the next one
+                flushSensorData();
+                startFrame(now, version, buttonState);
+                stored = sample_encoder_add(&frameEncoder, &coded);
+            }
+        } else if (version == SENSOR_FRAME_VERSION_FUSED) {
+#if SENSOR_PAYLOAD_FUSED
+            FusedPacket fusedPacket;
+            packFused(sample, packet, &fusedPacket);
+            memcpy(slot, &fusedPacket, sizeof(fusedPacket));
+#endif
+        } else {
+            memcpy(slot, &packet, sizeof(packet));
+        }
+        if (stored) frameCount++;
+
+        // Button transitions go out at once; motion waits for a full batch,
+        // a full MTU or the deadline
+        bool full = delta ? frameCount >= DELTA_FRAME_MAX_SAMPLES || !sample_encoder_has_room(&frameEncoder)
+                          : frameCount >= capacity;
+        if (full || buttonChanged || now - frameStartUs >= SENSOR_FLUSH_DEADLINE_MS * 1000UL) {
+            flushSensorData();
+        }
+    }
+    lastButtonState = buttonState;
 
-    if (buttonState > 0) {
-        Serial.printf("📤 Sending button press data: %s\\n",
-                     buttonState == 1 ? "BUTTON PRESS" : "LONG PRESS");
+    // Once per change: the state now rides along with every sample
+    if (buttonChanged) {
+        Serial.printf("📤 Sending button change #%u: %s\n", buttonSequence,
+                     buttonState == 1 ? "BUTTON PRESS" : buttonState == 2 ? "LONG PRESS" : "RELEASE");
     }
 
-    // Periodically show sensor data (every 100 packets ~2 seconds)
+    // Periodically show sensor data (about every 2 seconds)
     static int packetCount = 0;
-    if (buttonState == 0 && ++packetCount % 100 == 0) {
-        Serial.printf("📊 Sensor data - Accel: %.2f,%.2f,%.2f | Gyro: %.2f,%.2f,%.2f \n",
+    if (buttonState == 0 && ++packetCount % (SENSOR_SAMPLE_RATE_HZ * 2) == 0) {
+        Serial.printf("📊 Sensor data - Accel: %.2f,%.2f,%.2f | Gyro: %.2f,%.2f,%.2f | Overruns: %u \n",
                      packet.accel_x / 100.0f, packet.accel_y / 100.0f, packet.accel_z / 100.0f,
-                     packet.gyro_x / 10.0f, packet.gyro_y / 10.0f, packet.gyro_z / 10.0f);
+                     packet.gyro_x / 10.0f, packet.gyro_y / 10.0f, packet.gyro_z / 10.0f,
+                     samplerOverruns());
     }
 }
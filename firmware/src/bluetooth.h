@@ -5,6 +5,9 @@
 #include <BLEServer.h>
 #include <BLEUtils.h>
 #include <BLE2902.h>
+#include "sampler.h"
+#include "sample_codec.h"
+#include "sensor_frame.h"
 
 #define SERVICE_UUID        "12345678-1234-1234-1234-123456789abc"
 #define CHARACTERISTIC_UUID "87654321-4321-4321-4321-cba987654321"
@@ -17,13 +20,82 @@ struct SensorPacket {
     int16_t accel_x, accel_y, accel_z; ///< Acceleration * 100 (e.g., 1.5g = 150)
     int16_t gyro_x, gyro_y, gyro_z;    ///< Gyroscope * 10 (e.g., 5.5 deg/s = 55)
     uint8_t button_state;               ///< 0=none, 1=press, 2=long_press
-    uint8_t padding;                    ///< Padding for alignment
-    uint16_t timestamp;                 ///< Millisecond counter (wraps every 65 seconds)
+    uint8_t button_sequence;            ///< Count of button_state changes, wraps
+    uint16_t timestamp;                 ///< Bare packet: millisecond counter; in a frame: microseconds (low 16 bits)
 } __attribute__((packed));
 // Size: 6*2 + 1 + 1 + 2 = 16 bytes (well under 20 byte limit)
 
+/**
+ * @brief Sample of a fused frame: orientation and linear acceleration from
+ * the on-board AHRS. Same size and trailing fields as SensorPacket.
+ */
+struct FusedPacket {
+    int16_t quat_x, quat_y, quat_z;    ///< Quaternion vector part * 32767, w >= 0 is implied
+    int16_t linear_x, linear_y, linear_z; ///< Linear acceleration (sensor axes, gravity removed) * 1000
+    uint8_t button_state;
+    uint8_t button_sequence;
+    uint16_t timestamp;                 ///< Microseconds (low 16 bits)
+} __attribute__((packed));
+
+#ifndef SENSOR_BATCH_SIZE
+#define SENSOR_BATCH_SIZE 4          ///< Samples per notification once the MTU allows it (1 = bare packets)
+#endif
+
+#ifndef SENSOR_FLUSH_DEADLINE_MS
+#define SENSOR_FLUSH_DEADLINE_MS 10  ///< Maximum time the oldest buffered sample waits for its frame
+#endif
+
+#define SENSOR_FRAME_VERSION     3   ///< 1: ms timestamps, 2: us timestamps, 3: us plus button history
+#define SENSOR_FRAME_VERSION_FUSED 4 ///< Version 3 layout carrying FusedPackets
+#define SENSOR_FRAME_VERSION_DELTA 5 ///< Raw LSB readings, delta/varint coded after a DeltaFrameInfo
+
+#ifndef SENSOR_DELTA_FRAMES
+#define SENSOR_DELTA_FRAMES 1        ///< Raw samples go out as version 5 frames (0: version 3 SensorPackets)
+#endif
+#define SENSOR_FRAME_MAX_SPAN_US 65535 ///< Sample timestamps are 16-bit offsets from the header's
+
+/**
+ * @brief Header of a batched notification, followed by `count` SensorPackets.
+ * Only used when the negotiated MTU fits more than one sample; otherwise a
+ * bare SensorPacket is sent as before.
+ */
+struct SensorFrameHeader {
+    uint8_t version;    ///< SENSOR_FRAME_VERSION
+    uint8_t count;      ///< Number of samples following the header
+    uint16_t sequence;  ///< Frame counter, wraps at 65536
+    uint32_t timestamp; ///< Microsecond time of the first sample, extends the 16-bit sample timestamps
+} __attribute__((packed));
+
+/**
+ * @brief One button_state change, numbered like SensorPacket.button_sequence.
+ */
+struct ButtonEventRecord {
+    uint8_t sequence;
+    uint8_t state;
+} __attribute__((packed));
+
+/**
+ * @brief Follows the header, oldest change first. Every frame repeats the
+ * last few changes so the host can replay a click whose packets were lost.
+ */
+struct ButtonEventHistory {
+    ButtonEventRecord events[BUTTON_EVENT_HISTORY];
+} __attribute__((packed));
+
+/**
+ * @brief Follows the button history in version 5 frames, before the coded
+ * samples. A button change starts a new frame, so one state and sequence
+ * number covers every sample.
+ */
+struct DeltaFrameInfo {
+    uint8_t button_state;
+    uint8_t button_sequence;
+    SampleBlockHeader block;   ///< Encoding and full-scale ranges of the coded readings
+} __attribute__((packed));
+
 extern BLECharacteristic* pCharacteristic; ///< Pointer to the BLE characteristic used for sending data.
 extern bool deviceConnected;               ///< Flag to indicate if a BLE client is connected.
+extern uint16_t peerMtu;                   ///< ATT MTU negotiated with the connected client.
 
 /**
  * @brief Initializes the Bluetooth Low Energy (BLE) server, service, and characteristic.
@@ -31,10 +103,26 @@ extern bool deviceConnected;               ///< Flag to indicate if a BLE client
 void initBluetooth();
 
 /**
- * @brief Packages and sends sensor data over BLE.
+ * @brief Queues one IMU sample for transmission over BLE.
+ *
+ * Samples are batched into one notification until the batch is full, the
+ * flush deadline passes or the button state changes. With
+ * SENSOR_PAYLOAD_FUSED, frames carry the on-board orientation once the AHRS
+ * has settled; bare packets always carry raw readings.
  *
+ * @param sample The reading, stamped by the sampler.
  * @param buttonState The current state of the button to be included in the packet.
  */
-void sendSensorData(uint8_t buttonState);
+void sendSensorData(const ImuSample& sample, uint8_t buttonState);
+
+/**
+ * @brief Sends any buffered samples immediately.
+ */
+void flushSensorData();
+
+/**
+ * @brief Discards buffered samples and restarts the frame sequence, e.g. after a disconnect.
+ */
+void resetSensorData();
 
 #endif
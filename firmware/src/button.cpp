@@ -0,0 +1,79 @@
+#include "button.h"
+
+static void enterPhase(ButtonFsm* fsm, ButtonPhase phase, uint32_t nowMs) {
+    fsm->phase = phase;
+    fsm->phaseSinceMs = nowMs;
+}
+
+void buttonInit(ButtonFsm* fsm, uint32_t nowMs) {
+    fsm->phase = BUTTON_IDLE;
+    fsm->rawLevel = false;
+    fsm->rawSinceMs = nowMs;
+    fsm->level = false;
+    fsm->phaseSinceMs = nowMs;
+}
+
+ButtonEvent buttonUpdate(ButtonFsm* fsm, bool pressed, uint32_t nowMs) {
+    // Debounce: a level counts once it has been stable long enough
+    if (pressed != fsm->rawLevel) {
+        fsm->rawLevel = pressed;
+        fsm->rawSinceMs = nowMs;
+    }
+    bool edge = false;
+    if (fsm->rawLevel != fsm->level && nowMs - fsm->rawSinceMs >= BUTTON_DEBOUNCE_MS) {
+        fsm->level = fsm->rawLevel;
+        edge = true;
+    }
+
+    uint32_t elapsed = nowMs - fsm->phaseSinceMs;
+    switch (fsm->phase) {
+        case BUTTON_IDLE:
+            if (edge && fsm->level) enterPhase(fsm, BUTTON_PRESSED, nowMs);
+            break;
+
+        case BUTTON_PRESSED:
+            if (edge && !fsm->level) {
+                enterPhase(fsm, BUTTON_CLICK, nowMs);
+                return BUTTON_EVENT_CLICK;
+            }
+            if (elapsed >= BUTTON_LONG_PRESS_MS) {
+                enterPhase(fsm, BUTTON_LONG, nowMs);
+                return BUTTON_EVENT_LONG_PRESS;
+            }
+            break;
+
+        case BUTTON_CLICK:
+            if (elapsed >= BUTTON_CLICK_MS) enterPhase(fsm, BUTTON_AFTER_CLICK, nowMs);
+            break;
+
+        case BUTTON_AFTER_CLICK:
+            // Any press here is new: the click phase began on a release
+            if (fsm->level) {
+                enterPhase(fsm, BUTTON_DRAG, nowMs);
+                return BUTTON_EVENT_DOUBLE_PRESS;
+            }
+            if (elapsed >= BUTTON_DOUBLE_CLICK_MS) enterPhase(fsm, BUTTON_IDLE, nowMs);
+            break;
+
+        case BUTTON_LONG:
+        case BUTTON_DRAG:
+            if (edge && !fsm->level) {
+                enterPhase(fsm, BUTTON_IDLE, nowMs);
+                return BUTTON_EVENT_RELEASE;
+            }
+            break;
+    }
+    return BUTTON_EVENT_NONE;
+}
+
+ButtonReport buttonReport(const ButtonFsm* fsm) {
+    switch (fsm->phase) {
+        case BUTTON_CLICK:
+        case BUTTON_DRAG:
+            return BUTTON_REPORT_LEFT;
+        case BUTTON_LONG:
+            return BUTTON_REPORT_RIGHT;
+        default:
+            return BUTTON_REPORT_NONE;
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef BUTTON_H
+#define BUTTON_H
+
+#include <stdint.h>
+
+#ifndef BUTTON_DEBOUNCE_MS
+#define BUTTON_DEBOUNCE_MS     15   ///< Raw level must hold this long to count
+#endif
+
+#ifndef BUTTON_LONG_PRESS_MS
+#define BUTTON_LONG_PRESS_MS   500  ///< Hold time that turns a press into a right click
+#endif
+
+#ifndef BUTTON_DOUBLE_CLICK_MS
+#define BUTTON_DOUBLE_CLICK_MS 300  ///< Window after a click in which a second press is a double click
+#endif
+
+#define BUTTON_CLICK_MS 20          ///< How long a click is reported down, several samples at 200 Hz
+
+/**
+ * @brief Button states carried in SensorPacket.button_state.
+ */
+enum ButtonReport : uint8_t {
+    BUTTON_REPORT_NONE = 0,
+    BUTTON_REPORT_LEFT = 1,
+    BUTTON_REPORT_RIGHT = 2
+};
+
+/**
+ * @brief Gesture recognised by buttonUpdate(), for feedback on the device.
+ */
+enum ButtonEvent : uint8_t {
+    BUTTON_EVENT_NONE,
+    BUTTON_EVENT_CLICK,         ///< Short press released: left click
+    BUTTON_EVENT_LONG_PRESS,    ///< Held past BUTTON_LONG_PRESS_MS: right button down
+    BUTTON_EVENT_DOUBLE_PRESS,  ///< Second press after a click: left down until released (drag)
+    BUTTON_EVENT_RELEASE        ///< Long press or double press released
+};
+
+enum ButtonPhase : uint8_t {
+    BUTTON_IDLE,
+    BUTTON_PRESSED,             ///< Down, not yet known to be a click or a long press
+    BUTTON_CLICK,               ///< Released after a short press, reporting left down
+    BUTTON_AFTER_CLICK,         ///< Waiting for a possible second press
+    BUTTON_LONG,                ///< Right button held
+    BUTTON_DRAG                 ///< Left button held after a double press
+};
+
+/**
+ * @brief Debounce, click, long-press and double-press recognition driven
+ * only by timestamps, so it never blocks the sampling loop.
+ *
+ * Free of Arduino dependencies so it can run on a host.
+ */
+struct ButtonFsm {
+    ButtonPhase phase;
+    bool rawLevel;          ///< Last raw reading
+    uint32_t rawSinceMs;    ///< When the raw reading last changed
+    bool level;             ///< Debounced level
+    uint32_t phaseSinceMs;  ///< When the current phase started
+};
+
+/**
+ * @brief Resets the state machine to released.
+ *
+ * @param fsm State machine to reset.
+ * @param nowMs Current time.
+ */
+void buttonInit(ButtonFsm* fsm, uint32_t nowMs);
+
+/**
+ * @brief Feeds one raw button reading.
+ *
+ * @param fsm State machine.
+ * @param pressed Raw button level.
+ * @param nowMs Current time, may wrap.
+ * @return The gesture completed by this reading, if any.
+ */
+ButtonEvent buttonUpdate(ButtonFsm* fsm, bool pressed, uint32_t nowMs);
+
+/**
+ * @brief Button state to put in the next sensor packets.
+ */
+ButtonReport buttonReport(const ButtonFsm* fsm);
+
+#endif
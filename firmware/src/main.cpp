@@ -5,11 +5,37 @@
 #include <BLE2902.h>
 #include "bluetooth.h"
 #include "sensor.h"
+#include "sampler.h"
+#include "sample_clock.h"
+#include "button.h"
 
 BLEServer* pServer = NULL;
 BLECharacteristic* pCharacteristic = NULL;
 bool deviceConnected = false;
 bool oldDeviceConnected = false;
+static ButtonFsm button;
+
+/**
+ * Sends every sample the sampler queued since the last call, tagged with
+ * the given button state. Samples taken while disconnected are discarded.
+ */
+static void sendPendingSamples(uint8_t buttonState) {
+  static uint8_t sentButtonState = 0;
+  ImuSample sample;
+  bool pending = popSample(&sample);
+
+  // A button change goes out with the next sample rather than the next pass
+  if (!pending && buttonState != sentButtonState) {
+    waitForSamples(samplePeriodUs(SENSOR_SAMPLE_RATE_HZ) / 1000 + 1);
+    pending = popSample(&sample);
+  }
+
+  while (pending) {
+    sendSensorData(sample, buttonState);
+    sentButtonState = buttonState;
+    pending = popSample(&sample);
+  }
+}
 
 /**
  * BLE Server Callbacks to handle connection events
@@ -23,9 +49,16 @@ class MyServerCallbacks: public BLEServerCallbacks {
 
     void onDisconnect(BLEServer* pServer) {
       deviceConnected = false;
+      peerMtu = 23;
+      resetSensorData();
       M5.dis.fillpix(0xff0000); // Red when disconnected
       Serial.println("🔴 BLE CLIENT DISCONNECTED!");
     }
+
+    void onMtuChanged(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+      peerMtu = param->mtu.mtu;
+      Serial.printf("📏 MTU negotiated: %u bytes\n", peerMtu);
+    }
 };
 
 /**
@@ -95,11 +128,15 @@ void setup() {
   pAdvertising->setMinPreferred(0x0);
   BLEDevice::startAdvertising();
 
+  // Sample on a fixed timer from here on; loop() only forwards the samples
+  buttonInit(&button, millis());
+  startSampler();
+
   M5.dis.fillpix(0xff0000); // Tomato Red = ready/advertising
   Serial.println("✅ Setup complete! Ready for connections.");
   Serial.println("🔴 LED RED = Advertising/Disconnected");
   Serial.println("🟢 LED GREEN = Connected");
-  Serial.println("🔘 Button: Short press = Left click, Long press = Right click\n");
+  Serial.println("🔘 Button: Short press = Left click, Long press = Right click, Double press + hold = Drag\n");
 }
 
 /**
@@ -108,36 +145,37 @@ void setup() {
 void loop() {
   M5.update();
 
-  // Handle button press (simple click only)
-  static bool lastButtonState = false;
-  bool currentButtonState = M5.Btn.isPressed();
-
-  if (currentButtonState && !lastButtonState) {
-    // Button pressed
-    Serial.println("🖱️ BUTTON pressed");
-    sendSensorData(1); // Left click
-    M5.dis.fillpix(0x48d1cc); // Medium Turquoise for click
-    delay(200); // Debounce
-  } else if (currentButtonState && lastButtonState) {
-    // Long press
-    sendSensorData(2); // Long press
-    M5.dis.fillpix(0xff00ff); // Magenta for long press
-    Serial.println("🖱️ BUTTON still pressed");
-    delay(200); // Debounce
+  // Button gestures are recognised from timestamps, so sampling and
+  // cursor motion continue while the button is down
+  ButtonEvent event = buttonUpdate(&button, M5.Btn.isPressed(), millis());
+  switch (event) {
+    case BUTTON_EVENT_CLICK:
+      Serial.println("🖱️ BUTTON click");
+      M5.dis.fillpix(0x48d1cc); // Medium Turquoise for click
+      break;
+    case BUTTON_EVENT_DOUBLE_PRESS:
+      Serial.println("🖱️ BUTTON double press, holding left");
+      M5.dis.fillpix(0x48d1cc);
+      break;
+    case BUTTON_EVENT_LONG_PRESS:
+      Serial.println("🖱️ BUTTON long press");
+      M5.dis.fillpix(0xff00ff); // Magenta for long press
+      break;
+    case BUTTON_EVENT_RELEASE:
+      Serial.println("🖱️ BUTTON released");
+      break;
+    default:
+      break;
   }
-  else if (!currentButtonState && lastButtonState) {
-    // Button released
-    Serial.println("🖱️ BUTTON released");
-    sendSensorData(0); // Release
+
+  ButtonReport report = buttonReport(&button);
+  static ButtonReport lastReport = BUTTON_REPORT_NONE;
+  if (report == BUTTON_REPORT_NONE && lastReport != BUTTON_REPORT_NONE) {
     M5.dis.fillpix(deviceConnected ? 0x00ff00 : 0xff0000);
   }
+  lastReport = report;
 
-  lastButtonState = currentButtonState;
-
-  // Send sensor data continuously when connected
-  if (deviceConnected && !currentButtonState) {
-    sendSensorData(0); // Normal sensor data (only when button not pressed)
-  }
+  sendPendingSamples(report);
 
   // Handle disconnection
   if (!deviceConnected && oldDeviceConnected) {
@@ -152,5 +190,7 @@ void loop() {
     oldDeviceConnected = deviceConnected;
   }
 
-  delay(5); // 200Hz update rate for improved responsiveness
+  // Sleep until the sampler has something new; the timeout keeps the
+  // button polled when no samples arrive
+  waitForSamples(BUTTON_DEBOUNCE_MS / 3);
 }
@@ -0,0 +1,28 @@
+#include "sample_clock.h"
+#include "sample_queue.h"
+
+uint32_t samplePeriodUs(uint32_t rateHz) {
+    return 1000000 / rateHz;
+}
+
+void sampleClockInit(SampleClock* clock, uint32_t rateHz, SampleClockNow now, SampleClockRead read) {
+    clock->now = now;
+    clock->read = read;
+    clock->periodUs = samplePeriodUs(rateHz);
+    clock->lastReadUs = 0;
+    clock->started = false;
+}
+
+float sampleClockRead(SampleClock* clock, ImuSample* sample) {
+    // Stamp before the I2C transfer: the read itself takes a few hundred us
+    uint32_t now = clock->now();
+    int16_t accel[3], gyro[3];
+    clock->read(accel, gyro);
+    sampleFromRaw(sample, now, accel, gyro);
+
+    // Unsigned difference, so the 71-minute wrap does not show
+    uint32_t intervalUs = clock->started ? now - clock->lastReadUs : clock->periodUs;
+    clock->lastReadUs = now;
+    clock->started = true;
+    return intervalUs / 1000000.0f;
+}
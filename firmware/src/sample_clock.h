@@ -0,0 +1,51 @@
+#ifndef SAMPLE_CLOCK_H
+#define SAMPLE_CLOCK_H
+
+#include <stdint.h>
+#include "sampler.h"
+
+typedef uint32_t (*SampleClockNow)();                          ///< Microseconds, wrapping
+typedef void (*SampleClockRead)(int16_t accel[3], int16_t gyro[3]); ///< Raw IMU read, see sensor.h
+
+/**
+ * @brief Sampling period and read-time stamping for the sampler task.
+ *
+ * The clock and the IMU read are passed in (esp_timer and getSensorRaw()
+ * on the device), so it can run on a host with a fake clock.
+ */
+struct SampleClock {
+    SampleClockNow now;
+    SampleClockRead read;
+    uint32_t periodUs;      ///< Timer period for the sampling rate
+    uint32_t lastReadUs;    ///< Stamp of the previous read
+    bool started;           ///< A read has been stamped since init
+};
+
+/**
+ * @brief Timer period for a sampling rate.
+ *
+ * @param rateHz Samples per second.
+ * @return Period in microseconds.
+ */
+uint32_t samplePeriodUs(uint32_t rateHz);
+
+/**
+ * @brief Sets up the period for a rate and forgets the previous read.
+ *
+ * @param clock Clock to set up.
+ * @param rateHz Samples per second.
+ * @param now Time source.
+ * @param read IMU read.
+ */
+void sampleClockInit(SampleClock* clock, uint32_t rateHz, SampleClockNow now, SampleClockRead read);
+
+/**
+ * @brief Reads the IMU and stamps the sample with the time the read started.
+ *
+ * @param clock Clock of the sampler task.
+ * @param sample Sample to fill; the fused fields are left alone.
+ * @return Seconds since the previous read, one period for the first.
+ */
+float sampleClockRead(SampleClock* clock, ImuSample* sample);
+
+#endif
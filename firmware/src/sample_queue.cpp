@@ -0,0 +1,47 @@
+#include "sample_queue.h"
+#include <string.h>
+#include "sensor.h"
+
+#define ACCEL_LSB_G  (SENSOR_ACCEL_RANGE_G / 32768.0f)
+#define GYRO_LSB_DPS (SENSOR_GYRO_RANGE_DPS / 32768.0f)
+
+void sampleQueueInit(SampleQueue* queue) {
+    queue->head = 0;
+    queue->tail = 0;
+    queue->overruns = 0;
+}
+
+bool sampleQueuePush(SampleQueue* queue, const ImuSample& sample) {
+    uint32_t head = queue->head;
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= SAMPLE_QUEUE_SIZE) {
+        queue->overruns++;
+        return false;
+    }
+
+    queue->slots[head & (SAMPLE_QUEUE_SIZE - 1)] = sample;
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool sampleQueuePop(SampleQueue* queue, ImuSample* sample) {
+    uint32_t tail = queue->tail;
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    if (tail == head) return false;
+
+    *sample = queue->slots[tail & (SAMPLE_QUEUE_SIZE - 1)];
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void sampleFromRaw(ImuSample* sample, uint32_t timestampUs, const int16_t accel[3], const int16_t gyro[3]) {
+    sample->timestampUs = timestampUs;
+    memcpy(sample->accel_lsb, accel, sizeof(sample->accel_lsb));
+    memcpy(sample->gyro_lsb, gyro, sizeof(sample->gyro_lsb));
+    sample->accel_x = accel[0] * ACCEL_LSB_G;
+    sample->accel_y = accel[1] * ACCEL_LSB_G;
+    sample->accel_z = accel[2] * ACCEL_LSB_G;
+    sample->gyro_x = gyro[0] * GYRO_LSB_DPS;
+    sample->gyro_y = gyro[1] * GYRO_LSB_DPS;
+    sample->gyro_z = gyro[2] * GYRO_LSB_DPS;
+}
@@ -0,0 +1,55 @@
+#ifndef SAMPLE_QUEUE_H
+#define SAMPLE_QUEUE_H
+
+#include <stdint.h>
+#include "sampler.h"
+
+/**
+ * @brief Single-producer/single-consumer ring of IMU samples: the sampler
+ * task owns head, loop() owns tail.
+ *
+ * Free of Arduino dependencies so it can run on a host.
+ */
+struct SampleQueue {
+    ImuSample slots[SAMPLE_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t overruns;  ///< Samples dropped because the queue was full
+};
+
+/**
+ * @brief Empties the queue and clears the overrun count.
+ *
+ * @param queue Queue to reset.
+ */
+void sampleQueueInit(SampleQueue* queue);
+
+/**
+ * @brief Queues a sample; the newest is dropped and counted when full.
+ *
+ * @param queue Queue, producer side.
+ * @param sample Sample to copy in.
+ * @return true if the sample was queued.
+ */
+bool sampleQueuePush(SampleQueue* queue, const ImuSample& sample);
+
+/**
+ * @brief Takes the oldest queued sample.
+ *
+ * @param queue Queue, consumer side.
+ * @param sample Receives the sample.
+ * @return true if a sample was available.
+ */
+bool sampleQueuePop(SampleQueue* queue, ImuSample* sample);
+
+/**
+ * @brief Fills in a sample from raw readings and the time they were read.
+ *
+ * @param sample Sample to fill; the fused fields are left alone.
+ * @param timestampUs Time of the read.
+ * @param accel Acceleration in sensor LSBs, see sensor.h.
+ * @param gyro Rotation rate in sensor LSBs.
+ */
+void sampleFromRaw(ImuSample* sample, uint32_t timestampUs, const int16_t accel[3], const int16_t gyro[3]);
+
+#endif
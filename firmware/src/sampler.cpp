@@ -0,0 +1,127 @@
+#include "sampler.h"
+#include "sample_clock.h"
+#include "sample_queue.h"
+#include "sensor.h"
+#include <M5Atom.h>
+#include <esp_timer.h>
+#if SENSOR_PAYLOAD_FUSED
+#include "Fusion.h"
+#endif
+
+static SampleQueue sampleQueue;
+static SampleClock sampleClock;
+
+static TaskHandle_t samplerTask = NULL;
+static TaskHandle_t consumerTask = NULL;
+static esp_timer_handle_t sampleTimer = NULL;
+
+#if SENSOR_PAYLOAD_FUSED
+// Owned by the sampler task once it runs
+static FusionAhrs ahrs;
+static FusionOffset gyroOffset;
+
+/**
+ * Same AHRS settings as the driver uses when it fuses on the host
+ */
+static void initFusion() {
+    FusionOffsetInitialise(&gyroOffset, SENSOR_SAMPLE_RATE_HZ);
+    FusionAhrsInitialise(&ahrs);
+
+    FusionAhrsSettings settings = {
+        .convention = FusionConventionNwu,
+        .gain = 1.0f,
+        .gyroscopeRange = 2000.0f,
+        .accelerationRejection = 10.0f,
+        .magneticRejection = 0.0f,
+        .recoveryTriggerPeriod = 2 * SENSOR_SAMPLE_RATE_HZ
+    };
+    FusionAhrsSetSettings(&ahrs, &settings);
+}
+
+/**
+ * Feeds one reading, dt seconds after the previous one, to the AHRS and
+ * stores the result in the sample
+ */
+static void fuseSample(ImuSample& sample, float dt) {
+    FusionVector gyroscope = {.axis = {sample.gyro_x, sample.gyro_y, sample.gyro_z}};
+    FusionVector accelerometer = {.axis = {sample.accel_x, sample.accel_y, sample.accel_z}};
+    gyroscope = FusionOffsetUpdate(&gyroOffset, gyroscope);
+    FusionAhrsUpdateNoMagnetometer(&ahrs, gyroscope, accelerometer, dt);
+
+    FusionQuaternion quaternion = FusionAhrsGetQuaternion(&ahrs);
+    FusionVector linear = FusionAhrsGetLinearAcceleration(&ahrs);
+    sample.quat_w = quaternion.element.w;
+    sample.quat_x = quaternion.element.x;
+    sample.quat_y = quaternion.element.y;
+    sample.quat_z = quaternion.element.z;
+    sample.linear_x = linear.axis.x;
+    sample.linear_y = linear.axis.y;
+    sample.linear_z = linear.axis.z;
+    sample.fused = !FusionAhrsGetFlags(&ahrs).initialising;
+}
+#endif
+
+static uint32_t timerNowUs() {
+    return (uint32_t)esp_timer_get_time();
+}
+
+/**
+ * Timer callback: runs in the esp_timer task, so only hand off to the sampler
+ */
+static void onSampleTimer(void* arg) {
+    xTaskNotifyGive(samplerTask);
+}
+
+/**
+ * Sampler task: one IMU read per timer tick, stamped at read time
+ */
+static void samplerLoop(void* arg) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        ImuSample sample;
+        float dt = sampleClockRead(&sampleClock, &sample);
+#if SENSOR_PAYLOAD_FUSED
+        fuseSample(sample, dt);
+#else
+        (void)dt;
+#endif
+        sampleQueuePush(&sampleQueue, sample);
+
+        if (consumerTask) xTaskNotifyGive(consumerTask);
+    }
+}
+
+void startSampler() {
+    consumerTask = xTaskGetCurrentTaskHandle();
+    sampleQueueInit(&sampleQueue);
+    sampleClockInit(&sampleClock, SENSOR_SAMPLE_RATE_HZ, timerNowUs, getSensorRaw);
+#if SENSOR_PAYLOAD_FUSED
+    initFusion();
+#endif
+
+    // Core 1 with loop(); the BLE stack runs on core 0
+    xTaskCreatePinnedToCore(samplerLoop, "imu-sampler", 4096, NULL, configMAX_PRIORITIES - 2, &samplerTask, 1);
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = onSampleTimer;
+    timerArgs.dispatch_method = ESP_TIMER_TASK;
+    timerArgs.name = "imu-sample";
+    esp_timer_create(&timerArgs, &sampleTimer);
+    esp_timer_start_periodic(sampleTimer, sampleClock.periodUs);
+
+    Serial.printf("⏱️ IMU sampling at %d Hz%s\n", SENSOR_SAMPLE_RATE_HZ,
+                  SENSOR_PAYLOAD_FUSED ? ", fused on the device" : "");
+}
+
+bool popSample(ImuSample* sample) {
+    return sampleQueuePop(&sampleQueue, sample);
+}
+
+void waitForSamples(uint32_t timeoutMs) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs));
+}
+
+uint32_t samplerOverruns() {
+    return sampleQueue.overruns;
+}
@@ -0,0 +1,68 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdint.h>
+
+#ifndef SENSOR_SAMPLE_RATE_HZ
+#define SENSOR_SAMPLE_RATE_HZ 200    ///< IMU sampling rate: 200, 500 or 1000 Hz
+#endif
+
+#if SENSOR_SAMPLE_RATE_HZ != 200 && SENSOR_SAMPLE_RATE_HZ != 500 && SENSOR_SAMPLE_RATE_HZ != 1000
+#error "SENSOR_SAMPLE_RATE_HZ must be 200, 500 or 1000"
+#endif
+
+#ifndef SENSOR_PAYLOAD_FUSED
+#define SENSOR_PAYLOAD_FUSED 0       ///< 1: run the AHRS on the device and stream orientation instead of raw readings
+#endif
+
+#define SAMPLE_QUEUE_SIZE 256        ///< Power of two; covers 250 ms at 1 kHz while loop() is busy
+
+/**
+ * @brief One IMU reading, stamped when it was taken.
+ */
+struct ImuSample {
+    float accel_x, accel_y, accel_z; ///< g
+    float gyro_x, gyro_y, gyro_z;    ///< deg/s
+    int16_t accel_lsb[3];            ///< The same readings in raw sensor LSBs, see sensor.h
+    int16_t gyro_lsb[3];
+#if SENSOR_PAYLOAD_FUSED
+    float quat_w, quat_x, quat_y, quat_z; ///< Orientation from the on-board AHRS, sensor axes
+    float linear_x, linear_y, linear_z;   ///< g, gravity removed, sensor axes
+    bool fused;                      ///< The AHRS has settled and the orientation is worth sending
+#endif
+    uint32_t timestampUs;            ///< esp_timer time of the read, wraps every 71 minutes
+};
+
+/**
+ * @brief Starts sampling the IMU at SENSOR_SAMPLE_RATE_HZ.
+ *
+ * A periodic esp_timer wakes a high-priority task that reads the IMU and
+ * queues the sample, so the rate no longer depends on how long loop()
+ * takes. With SENSOR_PAYLOAD_FUSED the same task also runs the Fusion
+ * AHRS on every reading, so orientation is tracked at the full IMU rate
+ * whatever the radio does. Must be called from the task that consumes the
+ * samples.
+ */
+void startSampler();
+
+/**
+ * @brief Takes the oldest queued sample.
+ *
+ * @param sample Receives the sample.
+ * @return true if a sample was available.
+ */
+bool popSample(ImuSample* sample);
+
+/**
+ * @brief Blocks until the sampler has queued a sample or the timeout passes.
+ *
+ * @param timeoutMs Maximum time to wait.
+ */
+void waitForSamples(uint32_t timeoutMs);
+
+/**
+ * @brief Samples dropped because the queue was full.
+ */
+uint32_t samplerOverruns();
+
+#endif
@@ -8,22 +8,19 @@ void initSensor() {
 }
 
 /**
- * Get accelerometer and gyroscope data
+ * Get raw accelerometer and gyroscope readings
  */
-void getSensorData(float* accel_x, float* accel_y, float* accel_z,
-                   float* gyro_x, float* gyro_y, float* gyro_z) {
+void getSensorRaw(int16_t accel[3], int16_t gyro[3]) {
 
     // Initialize to zero in case of read failure
-    if (accel_x) *accel_x = 0.0f;
-    if (accel_y) *accel_y = 0.0f;
-    if (accel_z) *accel_z = 0.0f;
-    if (gyro_x) *gyro_x = 0.0f;
-    if (gyro_y) *gyro_y = 0.0f;
-    if (gyro_z) *gyro_z = 0.0f;
+    for (int i = 0; i < 3; i++) {
+        accel[i] = 0;
+        gyro[i] = 0;
+    }
 
     // Read accelerometer data
-    M5.IMU.getAccelData(accel_x, accel_y, accel_z);
+    M5.IMU.getAccelAdc(&accel[0], &accel[1], &accel[2]);
 
     // Read gyroscope data
-    M5.IMU.getGyroData(gyro_x, gyro_y, gyro_z);
+    M5.IMU.getGyroAdc(&gyro[0], &gyro[1], &gyro[2]);
 }
@@ -1,6 +1,11 @@
 #ifndef SENSOR_H
 #define SENSOR_H
 
+#include <stdint.h>
+
+#define SENSOR_ACCEL_RANGE_G  8      ///< MPU6886 full scale as configured by M5.IMU.Init()
+#define SENSOR_GYRO_RANGE_DPS 2000
+
 /**
  * @brief Initializes the sensor.
  *
@@ -8,16 +13,14 @@
 void initSensor();
 
 /**
- * @brief Gets the sensor data from the accelerometer and gyroscope.
+ * @brief Reads the accelerometer and gyroscope in raw LSBs.
+ *
+ * One LSB is SENSOR_ACCEL_RANGE_G / 32768 g and SENSOR_GYRO_RANGE_DPS / 32768
+ * deg/s. Both arrays are zeroed if the read fails.
  *
- * @param accel_x Pointer to a float to store the X-axis acceleration.
- * @param accel_y Pointer to a float to store the Y-axis acceleration.
- * @param accel_z Pointer to a float to store the Z-axis acceleration.
- * @param gyro_x Pointer to a float to store the X-axis gyroscope data.
- * @param gyro_y Pointer to a float to store the Y-axis gyroscope data.
- * @param gyro_z Pointer to a float to store the Z-axis gyroscope data.
+ * @param accel Receives the X, Y and Z acceleration.
+ * @param gyro Receives the X, Y and Z rotation rate.
  */
-void getSensorData(float* accel_x, float* accel_y, float* accel_z,
-                   float* gyro_x, float* gyro_y, float* gyro_z);
+void getSensorRaw(int16_t accel[3], int16_t gyro[3]);
 
 #endif
@@ -0,0 +1,167 @@
+#include <unity.h>
+#include "button.h"
+
+#define POLL_MS 5   // loop() reads the button once per 200 Hz sample
+
+// The debounced level flips on the first reading BUTTON_DEBOUNCE_MS after
+// the raw level changed
+#define EDGE_MS (BUTTON_DEBOUNCE_MS + POLL_MS)
+
+static ButtonFsm fsm;
+static uint32_t nowMs;
+static int events[5];  // Count of each ButtonEvent seen
+
+// Holds the raw level for durationMs, reading it as loop() does
+static void hold(bool pressed, uint32_t durationMs) {
+    for (uint32_t t = 0; t < durationMs; t += POLL_MS) {
+        nowMs += POLL_MS;
+        events[buttonUpdate(&fsm, pressed, nowMs)]++;
+    }
+}
+
+// Feeds one reading and returns the report that goes into the next packet
+static ButtonReport readAt(bool pressed) {
+    nowMs += POLL_MS;
+    events[buttonUpdate(&fsm, pressed, nowMs)]++;
+    return buttonReport(&fsm);
+}
+
+void setUp() {
+    nowMs = 1000;
+    buttonInit(&fsm, nowMs);
+    for (int i = 0; i < 5; i++) events[i] = 0;
+}
+
+void tearDown() {}
+
+static void test_idle_reports_nothing() {
+    hold(false, 1000);
+    TEST_ASSERT_EQUAL(BUTTON_IDLE, fsm.phase);
+    TEST_ASSERT_EQUAL(BUTTON_REPORT_NONE, buttonReport(&fsm));
+    TEST_ASSERT_EQUAL_INT(1000 / POLL_MS, events[BUTTON_EVENT_NONE]);
+}
+
+// A short press is not reported while held: the left button goes down only
+// once it is released, for BUTTON_CLICK_MS
+static void test_click_reported_on_release() {
+    hold(true, 150);
+    TEST_ASSERT_EQUAL(BUTTON_PRESSED, fsm.phase);
+    TEST_ASSERT_EQUAL(BUTTON_REPORT_NONE, buttonReport(&fsm));
+
+    hold(false, EDGE_MS - POLL_MS);
+    TEST_ASSERT_EQUAL(BUTTON_REPORT_NONE, buttonReport(&fsm));
+    TEST_ASSERT_EQUAL(BUTTON_REPORT_LEFT, readAt(false));
+    TEST_ASSERT_EQUAL_INT(1, events[BUTTON_EVENT_CLICK]);
+
+    uint32_t leftMs = POLL_MS;
+    while (readAt(false) == BUTTON_REPORT_LEFT) leftMs += POLL_MS;
+    TEST_ASSERT_EQUAL_UINT32(BUTTON_CLICK_MS, leftMs);
+
+    hold(false, BUTTON_DOUBLE_CLICK_MS);
+    TEST_ASSERT_EQUAL(BUTTON_IDLE, fsm.phase);
+    TEST_ASSERT_EQUAL_INT(0, events[BUTTON_EVENT_RELEASE]);
+}
+
+// So a single press and hold never drags; it becomes a right click
+static void test_long_press_threshold() {
+    hold(true, EDGE_MS + BUTTON_LONG_PRESS_MS - POLL_MS);
+    TEST_ASSERT_EQUAL(BUTTON_PRESSED, fsm.phase);
+    TEST_ASSERT_EQUAL(BUTTON_REPORT_NONE, buttonReport(&fsm));
+
+    TEST_ASSERT_EQUAL(BUTTON_REPORT_RIGHT, readAt(true));
+    TEST_ASSERT_EQUAL_INT(1, events[BUTTON_EVENT_LONG_PRESS]);
+
+    hold(true, 2000);
+    TEST_ASSERT_EQUAL(BUTTON_REPORT_RIGHT, buttonReport(&fsm));
+
+    hold(false, EDGE_MS);
+    TEST_ASSERT_EQUAL(BUTTON_REPORT_NONE, buttonReport(&fsm));
+    TEST_ASSERT_EQUAL_INT(1, events[BUTTON_EVENT_RELEASE]);
+    TEST_ASSERT_EQUAL_INT(0, events[BUTTON_EVENT_CLICK]);
+}
+
+// Press and release are debounced alike, so the raw hold time is what counts
+static void test_released_just_before_threshold_is_click() {
+    hold(true, BUTTON_LONG_PRESS_MS - POLL_MS);
+    hold(false, EDGE_MS);
+    TEST_ASSERT_EQUAL_INT(1, events[BUTTON_EVENT_CLICK]);
+    TEST_ASSERT_EQUAL_INT(0, events[BUTTON_EVENT_LONG_PRESS]);
+}
+
+// Contact bounce shorter than BUTTON_DEBOUNCE_MS is not a press, and
+// bounce on release does not end one
+static void test_debounce() {
+    for (int i = 0; i < 20; i++) {
+        hold(true, BUTTON_DEBOUNCE_MS - POLL_MS);
+        hold(false, POLL_MS);
+    }
+    TEST_ASSERT_EQUAL(BUTTON_IDLE, fsm.phase);
+    TEST_ASSERT_FALSE(fsm.level);
+
+    hold(true, EDGE_MS - POLL_MS);
+    TEST_ASSERT_FALSE(fsm.level);
+    hold(true, POLL_MS);
+    TEST_ASSERT_TRUE(fsm.level);
+    TEST_ASSERT_EQUAL(BUTTON_PRESSED, fsm.phase);
+
+    hold(true, BUTTON_LONG_PRESS_MS);
+    TEST_ASSERT_EQUAL(BUTTON_LONG, fsm.phase);
+    hold(false, POLL_MS);
+    hold(true, POLL_MS);
+    TEST_ASSERT_EQUAL(BUTTON_REPORT_RIGHT, buttonReport(&fsm));
+    TEST_ASSERT_EQUAL_INT(0, events[BUTTON_EVENT_RELEASE]);
+}
+
+// Dragging takes a click then a second press within BUTTON_DOUBLE_CLICK_MS;
+// left stays down until that press is released
+static void test_double_press_drags() {
+    hold(true, 100);
+    hold(false, 100);
+    TEST_ASSERT_EQUAL_INT(1, events[BUTTON_EVENT_CLICK]);
+
+    hold(true, EDGE_MS - POLL_MS);
+    TEST_ASSERT_EQUAL(BUTTON_REPORT_NONE, buttonReport(&fsm));
+    TEST_ASSERT_EQUAL(BUTTON_REPORT_LEFT, readAt(true));
+    TEST_ASSERT_EQUAL_INT(1, events[BUTTON_EVENT_DOUBLE_PRESS]);
+
+    hold(true, 3000);
+    TEST_ASSERT_EQUAL(BUTTON_DRAG, fsm.phase);
+    TEST_ASSERT_EQUAL(BUTTON_REPORT_LEFT, buttonReport(&fsm));
+    TEST_ASSERT_EQUAL_INT(0, events[BUTTON_EVENT_LONG_PRESS]);
+
+    hold(false, EDGE_MS);
+    TEST_ASSERT_EQUAL(BUTTON_REPORT_NONE, buttonReport(&fsm));
+    TEST_ASSERT_EQUAL_INT(1, events[BUTTON_EVENT_RELEASE]);
+}
+
+static void test_second_press_after_window_is_new_press() {
+    hold(true, 100);
+    hold(false, EDGE_MS + BUTTON_CLICK_MS + BUTTON_DOUBLE_CLICK_MS);
+    TEST_ASSERT_EQUAL(BUTTON_IDLE, fsm.phase);
+
+    hold(true, 100);
+    TEST_ASSERT_EQUAL(BUTTON_PRESSED, fsm.phase);
+    TEST_ASSERT_EQUAL_INT(0, events[BUTTON_EVENT_DOUBLE_PRESS]);
+}
+
+// millis() wraps after 49 days
+static void test_long_press_across_clock_wrap() {
+    nowMs = UINT32_MAX - 100;
+    buttonInit(&fsm, nowMs);
+    hold(true, EDGE_MS + BUTTON_LONG_PRESS_MS);
+    TEST_ASSERT_EQUAL(BUTTON_REPORT_RIGHT, buttonReport(&fsm));
+    TEST_ASSERT_EQUAL_INT(1, events[BUTTON_EVENT_LONG_PRESS]);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_idle_reports_nothing);
+    RUN_TEST(test_click_reported_on_release);
+    RUN_TEST(test_long_press_threshold);
+    RUN_TEST(test_released_just_before_threshold_is_click);
+    RUN_TEST(test_debounce);
+    RUN_TEST(test_double_press_drags);
+    RUN_TEST(test_second_press_after_window_is_new_press);
+    RUN_TEST(test_long_press_across_clock_wrap);
+    return UNITY_END();
+}
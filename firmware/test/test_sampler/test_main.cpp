@@ -0,0 +1,172 @@
+#include <unity.h>
+#include <string.h>
+#include "sample_clock.h"
+#include "sample_queue.h"
+
+#define START_US 1000000  // Fake time at setUp
+#define READ_US  300      // How long the fake IMU read takes
+
+// Stands in for esp_timer: the timer fires once per period and the sampler
+// task wakes some latency later, then spends READ_US on the read
+static uint32_t fakeNowUs;
+static uint32_t timerUs;  // When the sample timer fires next
+static SampleClock sampleClock;
+static SampleQueue queue;
+
+static const int16_t ACCEL[3] = {4096, -2048, 1};
+static const int16_t GYRO[3] = {16, -32, 16384};
+
+static uint32_t fakeNow() {
+    return fakeNowUs;
+}
+
+static void fakeRead(int16_t accel[3], int16_t gyro[3]) {
+    memcpy(accel, ACCEL, sizeof(ACCEL));
+    memcpy(gyro, GYRO, sizeof(GYRO));
+    fakeNowUs += READ_US;
+}
+
+static uint32_t tickJitterUs(uint32_t tick) {
+    return (tick * 37) % 400;
+}
+
+// One pass of samplerLoop() at the fake time
+static bool sampleTick(uint32_t tick) {
+    ImuSample sample;
+    fakeNowUs = timerUs + tickJitterUs(tick);
+    sampleClockRead(&sampleClock, &sample);
+    timerUs += sampleClock.periodUs;
+    return sampleQueuePush(&queue, sample);
+}
+
+void setUp() {
+    fakeNowUs = START_US;
+    timerUs = START_US;
+    sampleClockInit(&sampleClock, SENSOR_SAMPLE_RATE_HZ, fakeNow, fakeRead);
+    sampleQueueInit(&queue);
+}
+
+void tearDown() {}
+
+static void test_period_from_rate() {
+    TEST_ASSERT_EQUAL_UINT32(5000, samplePeriodUs(200));
+    TEST_ASSERT_EQUAL_UINT32(2000, samplePeriodUs(500));
+    TEST_ASSERT_EQUAL_UINT32(1000, samplePeriodUs(1000));
+    TEST_ASSERT_EQUAL_UINT32(samplePeriodUs(SENSOR_SAMPLE_RATE_HZ), sampleClock.periodUs);
+}
+
+// The stamp is the start of the read, not when the I2C transfer finished
+static void test_stamped_when_read_starts() {
+    ImuSample sample;
+    fakeNowUs = START_US + 123;
+    float dt = sampleClockRead(&sampleClock, &sample);
+    TEST_ASSERT_EQUAL_UINT32(START_US + 123, sample.timestampUs);
+    TEST_ASSERT_EQUAL_UINT32(START_US + 123 + READ_US, fakeNowUs);
+    TEST_ASSERT_FLOAT_WITHIN(1e-7f, sampleClock.periodUs / 1000000.0f, dt);
+    TEST_ASSERT_EQUAL_INT16(-2048, sample.accel_lsb[1]);
+
+    // A late wakeup lengthens the next interval by exactly the lateness
+    fakeNowUs = START_US + 123 + sampleClock.periodUs + 250;
+    dt = sampleClockRead(&sampleClock, &sample);
+    TEST_ASSERT_FLOAT_WITHIN(1e-7f, (sampleClock.periodUs + 250) / 1000000.0f, dt);
+}
+
+static void test_scales_raw_readings() {
+    ImuSample sample;
+    sampleFromRaw(&sample, 1234, ACCEL, GYRO);
+
+    TEST_ASSERT_EQUAL_UINT32(1234, sample.timestampUs);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, sample.accel_x);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, -0.5f, sample.accel_y);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1000.0f, sample.gyro_z);
+    TEST_ASSERT_EQUAL_INT16(-2048, sample.accel_lsb[1]);
+    TEST_ASSERT_EQUAL_INT16(-32, sample.gyro_lsb[1]);
+}
+
+// loop() drains in bursts, but the timestamps stay those of the reads
+static void test_timestamps_spaced_by_read_time() {
+    uint32_t previous = 0;
+    uint32_t popped = 0;
+    for (uint32_t tick = 0; tick < 1000; tick++) {
+        TEST_ASSERT_TRUE(sampleTick(tick));
+        if (tick % 7 != 6) continue;
+
+        ImuSample sample;
+        while (sampleQueuePop(&queue, &sample)) {
+            if (popped > 0) {
+                uint32_t expected = sampleClock.periodUs + tickJitterUs(popped) - tickJitterUs(popped - 1);
+                TEST_ASSERT_EQUAL_UINT32(expected, sample.timestampUs - previous);
+            }
+            previous = sample.timestampUs;
+            popped++;
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(1000 - 1000 % 7, popped);
+    TEST_ASSERT_EQUAL_UINT32(0, queue.overruns);
+}
+
+// The microsecond stamp wraps every 71 minutes; the spacing must not
+static void test_spacing_across_clock_wrap() {
+    timerUs = UINT32_MAX - 2 * sampleClock.periodUs;
+    for (uint32_t tick = 0; tick < 5; tick++) sampleTick(0);
+
+    ImuSample previous, sample;
+    TEST_ASSERT_TRUE(sampleQueuePop(&queue, &previous));
+    while (sampleQueuePop(&queue, &sample)) {
+        TEST_ASSERT_EQUAL_UINT32(sampleClock.periodUs, sample.timestampUs - previous.timestampUs);
+        previous = sample;
+    }
+    TEST_ASSERT_TRUE(previous.timestampUs < sampleClock.periodUs * 3);
+
+    // The interval handed to the AHRS does not see the wrap either
+    fakeNowUs = timerUs;
+    TEST_ASSERT_FLOAT_WITHIN(1e-7f, sampleClock.periodUs / 1000000.0f, sampleClockRead(&sampleClock, &sample));
+}
+
+// A stalled loop() loses the newest samples, counts each one, and picks up
+// again in order once it drains
+static void test_overruns_counted_while_stalled() {
+    const uint32_t stalled = SAMPLE_QUEUE_SIZE + 40;
+    for (uint32_t tick = 0; tick < stalled; tick++) sampleTick(0);
+    TEST_ASSERT_EQUAL_UINT32(stalled - SAMPLE_QUEUE_SIZE, queue.overruns);
+
+    ImuSample sample;
+    uint32_t expected = START_US;
+    for (uint32_t i = 0; i < SAMPLE_QUEUE_SIZE; i++) {
+        TEST_ASSERT_TRUE(sampleQueuePop(&queue, &sample));
+        TEST_ASSERT_EQUAL_UINT32(expected, sample.timestampUs);
+        expected += sampleClock.periodUs;
+    }
+    TEST_ASSERT_FALSE(sampleQueuePop(&queue, &sample));
+
+    // The gap shows up as a jump in the timestamps, not as lost order
+    uint32_t resumedAt = timerUs;
+    TEST_ASSERT_TRUE(sampleTick(0));
+    TEST_ASSERT_TRUE(sampleQueuePop(&queue, &sample));
+    TEST_ASSERT_EQUAL_UINT32(resumedAt, sample.timestampUs);
+    TEST_ASSERT_EQUAL_UINT32((stalled - SAMPLE_QUEUE_SIZE) * sampleClock.periodUs, sample.timestampUs - expected);
+    TEST_ASSERT_EQUAL_UINT32(stalled - SAMPLE_QUEUE_SIZE, queue.overruns);
+}
+
+static void test_init_clears_overruns() {
+    for (uint32_t tick = 0; tick < SAMPLE_QUEUE_SIZE + 1; tick++) sampleTick(0);
+    TEST_ASSERT_EQUAL_UINT32(1, queue.overruns);
+
+    sampleQueueInit(&queue);
+    ImuSample sample;
+    TEST_ASSERT_EQUAL_UINT32(0, queue.overruns);
+    TEST_ASSERT_FALSE(sampleQueuePop(&queue, &sample));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_period_from_rate);
+    RUN_TEST(test_stamped_when_read_starts);
+    RUN_TEST(test_scales_raw_readings);
+    RUN_TEST(test_timestamps_spaced_by_read_time);
+    RUN_TEST(test_spacing_across_clock_wrap);
+    RUN_TEST(test_overruns_counted_while_stalled);
+    RUN_TEST(test_init_clears_overruns);
+    return UNITY_END();
+}